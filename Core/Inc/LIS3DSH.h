@@ -56,6 +56,30 @@ typedef struct LIS3DSH_Evnt_s{
 	SST_Evt super;
 }LIS3DSH_Evnt_t;
 
+/*one accelerometer sample*/
+typedef struct LIS3DSH_Sample_s{
+	LIS3DSH_Results_t Results;
+	uint32_t timestamp_ms; /*HAL tick when the sample was read*/
+	uint32_t seq; /*sample sequence number, consecutive unless samples were lost*/
+}LIS3DSH_Sample_t;
+
+/*new sample published with LIS3DSH_SAMPLE_SIG. The event is allocated from an event pool and
+ * shared by all subscribers without a copy, it is recycled after the last subscriber handled it
+ * so it must be treated as read only and not kept beyond the handler*/
+typedef struct LIS3DSH_SampleEvnt_s{
+	SST_Evt super;
+	LIS3DSH_Sample_t Sample;
+}LIS3DSH_SampleEvnt_t;
+
+/*latest sample, readable at any priority without disabling interrupts or locking the scheduler.
+ * A seqlock over two copies: the single writer updates one copy while the version steers readers
+ * to the other, so a reader that preempts the writer never waits and a reader preempted by the
+ * writer simply retries.*/
+typedef struct LIS3DSH_Snapshot_s{
+	uint32_t volatile version; /*odd while copy[0] is written, even while copy[1] is written*/
+	LIS3DSH_Sample_t copy[2];
+}LIS3DSH_Snapshot_t;
+
 #define LIS3DSH_BUFF_SIZE (16u)
 
 typedef struct LIS3DSH_task_s{
@@ -64,9 +88,10 @@ typedef struct LIS3DSH_task_s{
 	LIS3DSH_DRVRState_t DrvrState;
 	SST_TimeEvt pollTimer;
 	SST_Task const *SPIDeviceAO; /*active object that managers the spi peripheral for comms to chip.*/
-	LIS3DSH_Results_t Results;
-	SPIManager_Evnt_t TxRxTransactionEvent;
-	SPIManager_Job_t TxRxTransactionJob;
+	LIS3DSH_Snapshot_t Snapshot; /*latest sample, see LIS3DSH_get_sample*/
+	uint32_t sampleSeq; /*sequence number of the next sample*/
+	SPIManager_Job_t TxRxTransactionJob; /*job template copied into each dynamic request*/
+	SPIManager_Seg_t ReadSegs[2]; /*sample read: the address from spiTxBuffer, the axes into spiRxBuffer*/
 	uint8_t spiTxBuffer[LIS3DSH_BUFF_SIZE];
 	uint8_t spiRxBuffer[LIS3DSH_BUFF_SIZE];
 	uint8_t initStage; /*in the init state this walks through the initialisation steps of the device.*/
@@ -80,4 +105,12 @@ typedef struct LIS3DSH_task_s{
 void LIS3DSH_ctor(LIS3DSH_task_t * me, SST_Task const * const SPI_Manager_AO, GPIO_TypeDef * pcsGPIOPort, uint16_t csGPIOPin);
 
 LIS3DSH_Results_t LIS3DSH_get_accel_xyz(LIS3DSH_task_t * me);
+
+LIS3DSH_Sample_t LIS3DSH_get_sample(LIS3DSH_task_t const *const me);
+
+/*lock-free sample snapshot: store from a single task, load from any task or ISR*/
+void LIS3DSH_snapshot_store(LIS3DSH_Snapshot_t *const pSnap,
+		LIS3DSH_Sample_t const *const pSample);
+
+LIS3DSH_Sample_t LIS3DSH_snapshot_load(LIS3DSH_Snapshot_t const *const pSnap);
 #endif /* INC_LIS3DSH_H_ */
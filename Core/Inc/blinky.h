@@ -14,7 +14,6 @@
 typedef struct {
 	SST_Task super; /*Inherit SST task */
 	/** add additional task data here*/
-	SST_TimeEvt blinkyTimer; /*Timer provide cyclic call to the blinky task handler*/
 } BlinkyTask_T;
 
 /*Constructor for the blinky task*/
@@ -19,18 +19,18 @@ void set_blue_LED_duty(uint16_t duty);
 void set_red_LED_duty(uint16_t duty);
 void set_orange_LED_duty(uint16_t duty);
 void set_green_LED_duty(uint16_t duty);
-LIS3DSH_Results_t LIS3DSH_read(void);
+LIS3DSH_Sample_t LIS3DSH_read(void);
 
 /*Event signals for all project task queues shall use the same type*/
 typedef enum project_sigs_e{
-	/*blinky event signals*/
-	BLINKYTIMER,
 	/*spi handler event signals*/
 	SPI_TXRXREQ_SIG,
 	SPI_TXRXCOMPLETE_SIG,
 	SPI_TIMEOUT_SIG,
+	SPI_BACKOFF_SIG, /*a timed out job has waited out its backoff and may retry*/
 	/*LIS3DSH event signals*/
 	LIS3DSH_POLL_SIG,
+	LIS3DSH_SAMPLE_SIG, /*published LIS3DSH_SampleEvnt_t, subscribe to receive the samples*/
 	/**/
 	PRJ_SIGS_MAX,
 } project_sigs_t;
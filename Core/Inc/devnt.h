@@ -9,11 +9,28 @@
 #define INC_DEVNT_H_
 
 #include <stdint.h>
+#include "poolstats.h"
+
+/*leaf bitfields per pool, each covers 32 blocks. Up to 32 leaves (1024 blocks) fit under the
+ *single summary word, define a smaller value to save RAM in every pool*/
+#ifndef DEVNT_MAX_LEAVES
+#define DEVNT_MAX_LEAVES (32u)
+#endif
+
+#define DEVNT_MAX_BLOCKS (DEVNT_MAX_LEAVES * 32u)
+
+/*1 to use the portable C count leading zeros instead of the CMSIS __CLZ (CLZ instruction)*/
+#ifndef DEVNT_PORTABLE_CLZ
+#define DEVNT_PORTABLE_CLZ (0u)
+#endif
 
 typedef struct devnt_pool_s {
-	uint32_t freeList_bf; /*bitfield of free pool locations*/
+	uint32_t summary_bf; /*bit n set while freeList_bf[n] has a free block*/
+	uint32_t freeList_bf[DEVNT_MAX_LEAVES]; /*bitfields of free pool locations, 32 blocks each*/
+	uint32_t numBlocks;
 	uint32_t blockSize;
 	uint8_t *pmemPool; /*pointer to the start of the mempool*/
+	POOL_STATS_ATTR /*instrumentation, see poolstats.h*/
 } devnt_pool_t;
 
 void devnt_pool_init(devnt_pool_t *me, void *pMem, uint32_t memSize,
@@ -23,4 +40,15 @@ void* devnt_pool_get(devnt_pool_t *me, uint32_t Size);
 
 void devnt_pool_put(devnt_pool_t *me, uint8_t *block);
 
+#if (POOL_STATS != 0)
+pool_stats_t const* devnt_pool_get_stats(devnt_pool_t const *me);
+
+void devnt_pool_reset_stats(devnt_pool_t *me);
+#endif
+
+/*adapters to register a devnt_pool_t as an SST event pool (see SST_Evt_addPool)*/
+void* devnt_pool_evt_get(void *const me, uint32_t size);
+
+void devnt_pool_evt_put(void *const me, void *const block);
+
 #endif /* INC_DEVNT_H_ */
@@ -9,16 +9,23 @@
 #define INC_MEMPOOL_H_
 
 #include <stdint.h>
+#include "poolstats.h"
 
 typedef struct mpool_empty_s{
 	struct mpool_empty_s * next;
 }mpool_empty_t;
 
 
+/*blocks are handed out from a bump pointer until it reaches the end of the buffer and only join
+ *the free list once they are put back, so mpool_init doesn't touch the pool memory*/
 typedef struct mpool_s{
-	mpool_empty_t *head;
+	mpool_empty_t *head; /*blocks given back with mpool_put*/
+	uint8_t *bump; /*first block never handed out, its distance from pmemPool is the high-water mark*/
+	uint8_t *end; /*end of the last whole block*/
+	uint8_t *pmemPool; /*pointer to the start of the mempool*/
 	uint32_t free;
 	uint32_t blocksize;
+	POOL_STATS_ATTR /*instrumentation, see poolstats.h*/
 }mpool_t;
 
 
@@ -29,4 +36,93 @@ void* mpool_get(mpool_t *me);
 
 void mpool_put(mpool_t *me, uint8_t *block);
 
+/*get or put up to n blocks in one critical section, returns the number of blocks got*/
+uint32_t mpool_get_batch(mpool_t *me, void **blocks, uint32_t n);
+
+void mpool_put_batch(mpool_t *me, void *const *blocks, uint32_t n);
+
+/*most blocks ever in use at the same time*/
+uint32_t mpool_max_used(mpool_t const *me);
+
+#if (POOL_STATS != 0)
+pool_stats_t const* mpool_get_stats(mpool_t const *me);
+
+void mpool_reset_stats(mpool_t *me);
+#endif
+
+/*adapters to register a mpool_t as an SST event pool (see SST_Evt_addPool)*/
+void* mpool_evt_get(void *const me, uint32_t size);
+
+void mpool_evt_put(void *const me, void *const block);
+
+/*magazine cache in front of an mpool_t: every SST priority level gets a private stack of blocks
+ *(a magazine) that it gets from and puts to without a critical section, since contexts of the same
+ *priority never preempt each other. The shared pool is only locked to refill an empty magazine or
+ *flush a full one, MPOOL_MAG_BATCH blocks at a time. Up to MPOOL_MAG_SIZE blocks can sit in each
+ *magazine, so give the pool that many spare blocks per level that uses it. Levels at or above
+ *MPOOL_MAG_LEVELS (ISRs) use the pool directly.*/
+#ifndef MPOOL_MAG_SIZE
+#define MPOOL_MAG_SIZE (8u)
+#endif
+#ifndef MPOOL_MAG_LEVELS
+#define MPOOL_MAG_LEVELS (4u) /*priority levels 0 (main) to MPOOL_MAG_LEVELS - 1 are cached*/
+#endif
+#define MPOOL_MAG_BATCH (MPOOL_MAG_SIZE / 2u)
+
+typedef struct mpool_mag_s{
+	void *blocks[MPOOL_MAG_SIZE];
+	uint32_t n; /*blocks in the magazine*/
+	uint32_t nRefill; /*batches got from the pool*/
+	uint32_t nFlush; /*batches put back to the pool*/
+}mpool_mag_t;
+
+typedef struct mpool_cache_s{
+	mpool_t *pool; /*shared pool behind the magazines*/
+	mpool_mag_t mag[MPOOL_MAG_LEVELS];
+}mpool_cache_t;
+
+void mpool_cache_init(mpool_cache_t *me, mpool_t *pool);
+
+/*get/put from the magazine of the running priority level (SST_PORT_CURR_PRIO)*/
+void* mpool_cache_get(mpool_cache_t *me);
+
+void mpool_cache_put(mpool_cache_t *me, uint8_t *block);
+
+/*as above for a given level, only call from a context running at that priority*/
+void* mpool_cache_get_at(mpool_cache_t *me, uint8_t prio);
+
+void mpool_cache_put_at(mpool_cache_t *me, uint8_t *block, uint8_t prio);
+
+/*return the blocks of the running level's magazine to the pool*/
+void mpool_cache_flush(mpool_cache_t *me);
+
+void* mpool_cache_evt_get(void *const me, uint32_t size);
+
+void mpool_cache_evt_put(void *const me, void *const block);
+
+/*lock-free variant, never disables interrupts. The head is tagged with a generation counter so a
+ *get preempted between reading the head and swapping it can't be fooled by the same block being
+ *taken and put back meanwhile (ABA), unless exactly 65536 other gets and puts run during it*/
+#define MPOOL_LF_IDX_MSK (0xFFFFu) /*head bits holding the first free block index + 1, 0 if empty*/
+#define MPOOL_LF_GEN_INC (0x10000u) /*generation counter in the upper head bits*/
+
+typedef struct mpool_lf_s{
+	uint32_t volatile head; /*tagged head: generation | (first free block index + 1)*/
+	uint32_t volatile free;
+	uint32_t blocksize;
+	uint32_t numBlocks;
+	uint8_t *pmemPool; /*pointer to the start of the mempool*/
+}mpool_lf_t;
+
+void mpool_lf_init(mpool_lf_t *me, uint8_t *pMem, uint32_t memSize,
+		uint32_t blockSize);
+
+void* mpool_lf_get(mpool_lf_t *me);
+
+void mpool_lf_put(mpool_lf_t *me, uint8_t *block);
+
+void* mpool_lf_evt_get(void *const me, uint32_t size);
+
+void mpool_lf_evt_put(void *const me, void *const block);
+
 #endif /* INC_MEMPOOL_H_ */
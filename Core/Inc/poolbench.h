@@ -0,0 +1,78 @@
+/*
+ * poolbench.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Allocator microbenchmarks: standard get/put patterns run against mpool_t, mpool_lf_t,
+ *      devnt_pool_t and the C library malloc, on the target and on the host. Each run prints
+ *      one key=value line so the results can be tracked between commits. Times come from the task
+ *      statistics time-stamp (SST_PORT_STAT_TIME), the benchmarks are only built with
+ *      SST_TASK_STATS on.
+ */
+
+#ifndef INC_POOLBENCH_H_
+#define INC_POOLBENCH_H_
+
+#include <stdint.h>
+#include "sst.h"
+
+/*most blocks in a benchmarked pool, the pool memory and the held blocks are static*/
+#ifndef POOL_BENCH_MAX_BLOCKS
+#define POOL_BENCH_MAX_BLOCKS (256u)
+#endif
+
+#ifndef POOL_BENCH_BLOCK_SIZE
+#define POOL_BENCH_BLOCK_SIZE (16u)
+#endif
+
+/*gets and puts per run*/
+#ifndef POOL_BENCH_OPS
+#define POOL_BENCH_OPS (100000u)
+#endif
+
+/*1 to include malloc/free. The target needs an _sbrk (sysmem.c) and a heap of
+ *POOL_BENCH_MAX_BLOCKS blocks in the linker script for it, so it is off there by default*/
+#ifndef POOL_BENCH_MALLOC
+#ifdef SST_PORT_POSIX
+#define POOL_BENCH_MALLOC (1u)
+#else
+#define POOL_BENCH_MALLOC (0u)
+#endif
+#endif
+
+typedef enum {
+	POOL_BENCH_LIFO, /*fill the pool, free in reverse order*/
+	POOL_BENCH_FIFO, /*keep half the pool held, free the oldest block for each new one*/
+	POOL_BENCH_RANDOM, /*get or free a random held block, seeded so runs repeat*/
+	POOL_BENCH_BURSTY, /*a producer gets a burst of random length, the consumer frees it in order*/
+	POOL_BENCH_NUM_PATTERNS
+} pool_bench_pattern_t;
+
+/*an allocator under test, get and put have the signature of the event pool hooks
+ *(SST_Evt_initPool) so every pool plugs in with its evt_get/evt_put pair*/
+typedef struct pool_bench_alloc_s {
+	char const *name;
+	void (*init)(void *const pool, uint8_t *pMem, uint32_t memSize, uint32_t blockSize);
+	void* (*get)(void *const pool, uint32_t size);
+	void (*put)(void *const pool, void *const block);
+	void *pool;
+} pool_bench_alloc_t;
+
+typedef struct pool_bench_result_s {
+	uint32_t ops; /*gets and puts done*/
+	uint32_t time; /*SST_PORT_STAT_TIME units for all of them*/
+	uint32_t nFail; /*gets that found no block while the pattern held fewer than numBlocks*/
+	uint32_t fill; /*blocks that could be held at once after the pattern*/
+} pool_bench_result_t;
+
+/*runs one pattern against a freshly initialised allocator of numBlocks blocks
+ *(at most POOL_BENCH_MAX_BLOCKS)*/
+pool_bench_result_t pool_bench_run(pool_bench_alloc_t const *alloc, pool_bench_pattern_t pattern,
+		uint32_t numBlocks);
+
+/*every pattern against every built in allocator for 32 and POOL_BENCH_MAX_BLOCKS blocks, one
+ *printf line per run*/
+void pool_bench_run_all(void);
+
+#endif /* INC_POOLBENCH_H_ */
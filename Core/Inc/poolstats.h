@@ -0,0 +1,95 @@
+/*
+ * poolstats.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Optional instrumentation of the block allocators (mpool_t and devnt_pool_t): the lowest
+ *      number of free blocks, failed gets, the blocks held by each owner (the task or ISR that
+ *      got them) and histograms of the get and put times. With POOL_STATS 0 the statistics and
+ *      all their code compile away.
+ */
+
+#ifndef INC_POOLSTATS_H_
+#define INC_POOLSTATS_H_
+
+#include <stdint.h>
+#include "sst.h"
+
+/*off by default, enable by defining POOL_STATS to 1 in the compiler options. Times are taken
+ *with the task statistics time-stamp so SST_TASK_STATS must be on too (it starts the cycle counter
+ *on the target)*/
+#ifndef POOL_STATS
+#define POOL_STATS 0
+#endif
+
+#if (POOL_STATS != 0)
+
+#if (SST_TASK_STATS == 0)
+#error "POOL_STATS times come from the SST_TASK_STATS time-stamp (SST_PORT_STAT_TIME)"
+#endif
+
+#ifndef POOL_STATS_MAX_OWNERS
+#define POOL_STATS_MAX_OWNERS (8u) /*tasks and ISRs tracked per pool*/
+#endif
+
+#ifndef POOL_STATS_MAX_BLOCKS
+#define POOL_STATS_MAX_BLOCKS (64u) /*blocks of a pool attributed to their owner*/
+#endif
+
+/*bin n counts the times in [2^(n-1), 2^n) of SST_PORT_STAT_TIME units, the last bin is open
+ *ended. CPU cycles on the target, ns on the host*/
+#define POOL_STATS_HIST_BINS (16u)
+
+#define POOL_STATS_NO_OWNER (0xFFFFu)
+
+typedef struct pool_owner_stats_s {
+	uint16_t ctx; /*SST_PORT_CURR_CTX() of the owner (16 + IRQ of the task), POOL_STATS_NO_OWNER if unused*/
+	uint16_t used; /*blocks it holds now*/
+	uint16_t peak; /*most blocks it held at the same time*/
+} pool_owner_stats_t;
+
+typedef struct pool_stats_s {
+	uint32_t numBlocks;
+	uint32_t used; /*blocks handed out now*/
+	uint32_t minFree; /*lowest number of free blocks*/
+	uint32_t nGet; /*successful gets*/
+	uint32_t nFail; /*gets that found the pool empty (or the block too small)*/
+	uint32_t nPut;
+	pool_owner_stats_t owner[POOL_STATS_MAX_OWNERS];
+	uint8_t blockOwner[POOL_STATS_MAX_BLOCKS]; /*owner index + 1 of each block in use, 0 untracked*/
+	uint32_t getHist[POOL_STATS_HIST_BINS];
+	uint32_t putHist[POOL_STATS_HIST_BINS];
+} pool_stats_t;
+
+void pool_stats_init(pool_stats_t *me, uint32_t numBlocks);
+
+/*restart the counters, minimum and peaks from the current state, blocks in use stay counted*/
+void pool_stats_reset(pool_stats_t *me);
+
+/*record a get, blockIdx is the index of the block in its pool or -1 if the get failed.
+ *call inside the pool's critical section*/
+void pool_stats_get(pool_stats_t *me, int32_t blockIdx, uint32_t time);
+
+/*record a put, call inside the pool's critical section*/
+void pool_stats_put(pool_stats_t *me, uint32_t blockIdx, uint32_t time);
+
+#define POOL_STATS_ATTR pool_stats_t stats;
+#define POOL_STATS_BEGIN(t0_) uint32_t const t0_ = SST_PORT_STAT_TIME()
+#define POOL_STATS_INIT(me_, numBlocks_) pool_stats_init(&(me_)->stats, (numBlocks_))
+#define POOL_STATS_GET(me_, idx_, t0_) \
+	pool_stats_get(&(me_)->stats, (idx_), SST_PORT_STAT_TIME() - (t0_))
+#define POOL_STATS_PUT(me_, idx_, t0_) \
+	pool_stats_put(&(me_)->stats, (idx_), SST_PORT_STAT_TIME() - (t0_))
+
+#else
+
+#define POOL_STATS_ATTR
+#define POOL_STATS_BEGIN(t0_) ((void)0)
+#define POOL_STATS_INIT(me_, numBlocks_) ((void)0)
+#define POOL_STATS_GET(me_, idx_, t0_) ((void)0)
+#define POOL_STATS_PUT(me_, idx_, t0_) ((void)0)
+
+#endif /* POOL_STATS */
+
+#endif /* INC_POOLSTATS_H_ */
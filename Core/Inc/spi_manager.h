@@ -14,42 +14,197 @@
 #include "sst.h"
 #include "main.h"
 
-#define SPIMANAGER_QUEUE_SIZE (16)
+#define SPIMANAGER_QUEUE_SIZE (16) /*jobs waiting for the bus or out their backoff, all priorities
+ together (max 254)*/
+
+/*every accepted request keeps a slot until it is answered, the waiting ones and the one on the bus*/
+#define SPIMANAGER_NUM_SLOTS (SPIMANAGER_QUEUE_SIZE + 1)
+
+/*job priorities, 0 (lowest) to SPIMANAGER_NUM_PRIOS - 1. The highest waiting priority starts next,
+ *jobs of the same priority start in the order they were requested*/
+#ifndef SPIMANAGER_NUM_PRIOS
+#define SPIMANAGER_NUM_PRIOS (8u)
+#endif
+
+/*aging: the oldest job of a priority starts anyway once SPIMANAGER_AGING_LIMIT jobs of higher
+ *priorities have started ahead of it, so low priority work can't starve. 0 disables aging*/
+#ifndef SPIMANAGER_AGING_LIMIT
+#define SPIMANAGER_AGING_LIMIT (8u)
+#endif
 
 typedef enum SPIManager_State_e {
 	SPI_MGR_BUSY, SPI_MGR_READY,
 } SPIManager_State_t;
 
+/*longest wait before retrying a timed out job, the backoff doubles from the job's backoff_ms for
+ *every retry up to this*/
+#ifndef SPIMANAGER_BACKOFF_MAX_MS
+#define SPIMANAGER_BACKOFF_MAX_MS (100u)
+#endif
+
+/*register engine: segments of up to this many bytes are busy-polled by the manager task, longer
+ *ones run on the RXNE interrupt. At the DISC1 SPI1 clock (84MHz / 32) a byte takes ~500 CPU
+ *cycles on the bus, about what the interrupt entry, HAL handler and completion post cost for a
+ *short transfer, see bench spi_reg*/
+#ifndef SPIMANAGER_POLL_MAX_LEN
+#define SPIMANAGER_POLL_MAX_LEN (8u)
+#endif
+
+/*status register reads a polled byte may take before the manager gives up on it and leaves the
+ *job to its timeout (a stuck bus must not hang the task)*/
+#ifndef SPIMANAGER_POLL_SPIN
+#define SPIMANAGER_POLL_SPIN (10000u)
+#endif
+
+/*register engine accesses to the SPI status and data registers. A board can define these before
+ *including this header to run the engine against a model of the peripheral (the host HAL does)*/
+#ifndef SPIMANAGER_SPI_SR
+#define SPIMANAGER_SPI_SR(regs_) ((regs_)->SR)
+#define SPIMANAGER_SPI_DR_WRITE(regs_, data_) (*(__IO uint8_t *)&((regs_)->DR) = (data_))
+#define SPIMANAGER_SPI_DR_READ(regs_) (*(__IO uint8_t *)&((regs_)->DR))
+#endif
+
+/*how the manager drives the transfers: an interrupt per byte (HAL *_IT), a DMA stream per
+ *transfer with a single interrupt at the end (HAL *_DMA, the SPI handle needs its hdmatx and
+ *hdmarx linked and the buffers must be in DMA reachable RAM, not the CCM) or the register engine
+ *(the manager writes the SPI registers itself, see SPIManager_set_RegEngine)*/
+typedef enum SPIManager_XferMode_e {
+	SPI_MGR_XFER_IT, SPI_MGR_XFER_DMA, SPI_MGR_XFER_REG,
+} SPIManager_XferMode_t;
+
+/*one contiguous transfer of a job, a NULL txData receives only (clocks out dummy bytes) and a NULL
+ *rxData transmits only*/
+typedef struct {
+	uint8_t *txData;
+	uint8_t *rxData;
+	uint16_t lenData;
+} SPIManager_Seg_t;
+
+/*bus settings of a slave, the SPI_InitTypeDef values (which are the SPI_CR1 bits). The jobs of a
+ *slave point at its descriptor and the manager rewrites the SPI configuration only when a job needs
+ *other settings than the ones loaded, so slaves on one bus each run at their own clock and mode.
+ *The register engine clocks 8 bit frames only*/
 typedef struct {
+	uint32_t BaudRatePrescaler; /*SPI_BAUDRATEPRESCALER_2 to _256 of the APB clock*/
+	uint32_t CLKPolarity; /*SPI_POLARITY_LOW or _HIGH (CPOL)*/
+	uint32_t CLKPhase; /*SPI_PHASE_1EDGE or _2EDGE (CPHA)*/
+	uint32_t DataSize; /*SPI_DATASIZE_8BIT or _16BIT, 16 bit buffers hold lenData frames*/
+} SPIManager_SlaveCfg_t;
+
+/*how a job ended, passed to its completion callback*/
+typedef enum SPIManager_JobStatus_e {
+	SPI_JOB_OK, SPI_JOB_TIMEOUT,
+} SPIManager_JobStatus_t;
+
+struct SPIManager_Job_s;
+
+/*completion callback, runs in the SPI manager task (at its priority) when the job or chain
+ *finishes instead of a response event, so it must be short and must not block. pJob is the
+ *first job of the chain (the manager's copy for dynamic requests)*/
+typedef void (*SPIManager_Callback_t)(struct SPIManager_Job_s const *const pJob,
+		SPIManager_JobStatus_t status);
+
+typedef struct SPIManager_Job_s {
 	SST_Task const *pAOrequester; /*active object that requested the SPI transaction job*/
 	GPIO_TypeDef * pcsGPIOPort; /*chip select port to use*/
 	uint16_t csGPIOPin;  /*chip select pin to use*/
+	SPIManager_SlaveCfg_t const *pSlaveCfg; /*bus settings of the slave, NULL for the settings the
+	 SPI was initialised with*/
 	uint8_t *txData;
 	uint8_t *rxData;
 	uint16_t lenData; /*Number of bytes in the job*/
 	uint16_t timeoutCnt_ms; /*timeout time the job*/
+	uint16_t backoff_ms; /*wait before the first retry of a timed out job, doubled for every later
+	 one (up to SPIMANAGER_BACKOFF_MAX_MS), other jobs get the bus meanwhile. 0 retries at once*/
+	uint8_t retries; /*times a timed out job (chain) is started again before the requester is told,
+	 0 to give up on the first timeout*/
+	uint8_t priority; /*0 (lowest) to SPIMANAGER_NUM_PRIOS - 1*/
+	uint8_t numSegs; /*segments in pSegs, 0 for the single txData/rxData/lenData transfer*/
+	SPIManager_Seg_t const *pSegs; /*transfers clocked back to back while the chip select stays low*/
+	struct SPIManager_Job_s const *pNext; /*job started straight after this one (chip select raised
+	 in between) without going through the queue, NULL ends the chain*/
+	SPIManager_Callback_t pfComplete; /*called on completion or timeout instead of posting
+	 SPI_TXRXCOMPLETE_SIG/SPI_TIMEOUT_SIG to pAOrequester, NULL for the events*/
+	void *pCallbackCtx; /*for the callback, e.g. the buffer to decode into*/
+	uint8_t detailedResp; /*1 to get the request event itself back as the SPI_TXRXCOMPLETE_SIG or
+	 SPI_TIMEOUT_SIG response, with its seq, status and busTime filled in, instead of the bare
+	 signal. Lets a requester keep several jobs in flight and tell which one finished*/
 } SPIManager_Job_t;
 
 /*jobs are passed to the SPIManager in its event quest*/
 typedef struct {
 	SST_Evt super; /*inherit SST event*/
 	SPIManager_Job_t *pJob;
+	/*filled in by the manager, which owns the request from when it accepts it until it answers, so
+	 *a request must not be posted again before then. For detailed responses (pJob->detailedResp)
+	 *the request comes back to the requester as the response, the job it carries is still valid
+	 *while the response is handled and SPIManager_post_txrx_Request may post it again*/
+	uint32_t seq; /*requests of the manager accepted before this one*/
+	uint32_t busTime; /*SST_PORT_STAT_TIME units from the first chip select low to the end of the
+	 job (chain), 0 on the target unless the cycle counter runs (SST_TASK_STATS)*/
+	SPIManager_JobStatus_t status;
+	uint8_t attempt; /*timeouts of the job so far, for jobs with retries*/
 } SPIManager_Evnt_t;
 
+/*dynamic request event that carries its own copy of the job, the manager holds a reference
+ * to it until the job has finished so the requester doesn't need to keep the job alive*/
+typedef struct {
+	SPIManager_Evnt_t super; /*inherit SPI manager request event (pJob points to Job)*/
+	SPIManager_Job_t Job;
+} SPIManager_JobEvnt_t;
+
 typedef struct SPIManager_Task_e {
 	SST_Task super;
 	/** add additional task data here*/
 	SPIManager_State_t MgrState; /*internal state of the device*/
+	SPIManager_XferMode_t XferMode; /*interrupt or DMA driven transfers*/
 	SPI_HandleTypeDef *pSPIPeriph; /*pointer to the peripheral*/
+	SPIManager_SlaveCfg_t defaultCfg; /*settings the SPI was initialised with (HAL_SPI_Init)*/
+	SPIManager_SlaveCfg_t busCfg; /*settings loaded in the SPI*/
+	uint32_t nReconfig; /*bus reconfigurations for a job of another slave*/
+	SPI_TypeDef *pRegs; /*SPI registers driven by the register engine*/
+	uint16_t pollMaxLen; /*register engine: longest busy-polled segment*/
+	uint8_t const *regTx; /*register engine: interrupt driven segment in progress*/
+	uint8_t *regRx;
+	uint16_t regLen;
+	uint16_t volatile regIdx; /*bytes clocked so far*/
+	uint32_t nPolledSegs; /*register engine segments busy-polled*/
+	uint32_t nIrqSegs; /*register engine segments run on the RXNE interrupt*/
 	SST_TimeEvt JobTimeoutTimer;   /*time event object used to timeout jobs*/
-	SPIManager_Job_t *pCurrentJob; /*current active job*/
-	SPIManager_Job_t *pMgrJobs[SPIMANAGER_QUEUE_SIZE];
-	uint32_t JobsHead;
-	uint32_t JobsTail;
+	uint8_t timeoutArmed; /*JobTimeoutTimer is armed for the job on the bus*/
+	uint8_t staleTimeouts; /*SPI_TIMEOUT_SIG posted for jobs that finished meanwhile, to drop*/
+	SST_TimeEvt BackoffTimer; /*posts SPI_BACKOFF_SIG when the first parked request may retry*/
+	uint8_t BackoffHead; /*timed out requests waiting out their backoff, the soonest due first*/
+	uint32_t JobsDue[SPIMANAGER_NUM_SLOTS]; /*HAL tick a parked request may retry at*/
+	uint32_t nTimeouts; /*jobs that timed out, retried or not*/
+	uint32_t nRetries; /*timed out jobs started again*/
+	uint32_t nAbandoned; /*jobs answered with SPI_TIMEOUT_SIG after their last retry*/
+	uint32_t nLateCplt; /*completions of aborted transfers, ignored*/
+	uint8_t cpltSuspect; /*a timeout aborted a transfer, the next completion may be its late one*/
+	SPIManager_Job_t const *pCurrentJob; /*current active job (of the chain of the current request)*/
+	uint8_t currentSeg; /*segment of the current job on the bus*/
+	SPIManager_Evnt_t *pCurrentReq; /*request event that carried the current job*/
+	uint8_t currentSlot; /*slot of the current request*/
+	SPIManager_Evnt_t *pMgrJobs[SPIMANAGER_NUM_SLOTS]; /*accepted requests not answered yet*/
+	uint8_t JobsNext[SPIMANAGER_NUM_SLOTS]; /*next slot of the same priority FIFO, of the backoff
+	 list or of the free list*/
+	uint8_t JobsHead[SPIMANAGER_NUM_PRIOS]; /*oldest waiting job of each priority*/
+	uint8_t JobsTail[SPIMANAGER_NUM_PRIOS]; /*newest waiting job of each priority*/
+	uint8_t JobsAge[SPIMANAGER_NUM_PRIOS]; /*jobs started ahead of the oldest job of each priority*/
+	uint8_t JobsFree; /*first free slot*/
+	uint32_t JobsReady; /*bit n set while jobs of priority n are waiting*/
+	uint32_t nAged; /*jobs started by the aging rule ahead of a higher priority*/
+	uint32_t nextSeq; /*sequence number of the next request accepted*/
+	uint32_t jobStart; /*SST_PORT_STAT_TIME when the current request started*/
 } SPIManager_Task_t;
 
 
 /**public function prototypes**/
 void SPIManager_ctor(SPIManager_Task_t *const me, SPI_HandleTypeDef *spiDevice);
+void SPIManager_set_XferMode(SPIManager_Task_t *const me, SPIManager_XferMode_t mode);
+void SPIManager_set_RegEngine(SPIManager_Task_t *const me, SPI_TypeDef *pRegs,
+		uint16_t pollMaxLen);
+void SPIManager_reg_IRQHandler(SPIManager_Task_t *const me);
 void SPIManager_post_txrx_Request(SST_Task *const AO, SPIManager_Evnt_t *pEvent);
+SPIManager_Evnt_t* SPIManager_new_txrx_Request(SPIManager_Job_t const *const pJob);
 #endif /* INC_SPI_MANAGER_H_ */
@@ -37,11 +37,56 @@ typedef uint16_t SST_Signal;
 /*! SST event class */
 typedef struct {
     SST_Signal sig;
+    uint8_t poolNum;         /*!< event pool number (0 for static events) */
+    uint8_t volatile refCtr; /*!< # queues holding a dynamic event */
 } SST_Evt;
 
 /*! macro for downcasting SST events to specific Evt "subclasses" */
 #define SST_EVT_DOWNCAST(EVT_, e_) ((EVT_ const *)(e_))
 
+/*! maximum number of event pools for dynamic events */
+#ifndef SST_MAX_EVT_POOLS
+#define SST_MAX_EVT_POOLS 3U
+#endif
+
+/*! event pool operations, so that any fixed-block allocator can back events */
+typedef void *(*SST_EvtPoolGet)(void * const pool, uint32_t size);
+typedef void (*SST_EvtPoolPut)(void * const pool, void * const block);
+
+/* register an event pool, pools must be added in ascending block size */
+void SST_Evt_addPool(
+    void * const pool,
+    uint16_t blockSize,
+    SST_EvtPoolGet get,
+    SST_EvtPoolPut put);
+
+/* allocate a dynamic event from the smallest pool that fits evtSize and
+* still has a free block (falls through to the larger pools when empty)
+*/
+SST_Evt *SST_Evt_new(uint16_t evtSize, SST_Signal sig);
+
+/*! statistics of one event pool (size class) */
+typedef struct {
+    uint32_t nAlloc;    /*!< events allocated from the pool */
+    uint32_t nFallback; /*!< allocations that a smaller, empty pool fits */
+    uint32_t nEmpty;    /*!< times the pool was found empty */
+    uint16_t nUsed;     /*!< events currently allocated from the pool */
+    uint16_t maxUsed;   /*!< high-water mark of nUsed */
+} SST_EvtPoolStat;
+
+/* statistics of the pool poolNum (1 for the first pool added) */
+SST_EvtPoolStat const *SST_Evt_getPoolStat(uint8_t poolNum);
+
+/* hold an extra reference to a dynamic event beyond its dispatch */
+void SST_Evt_ref(SST_Evt const * const e);
+
+/* drop a reference to a dynamic event and recycle it when unreferenced */
+void SST_Evt_gc(SST_Evt const * const e);
+
+/*! macro for allocating dynamic events of a specific Evt "subclass" */
+#define SST_EVT_NEW(EVT_, sig_) \
+    ((EVT_ *)SST_Evt_new((uint16_t)sizeof(EVT_), (sig_)))
+
 /* SST Task facilities -----------------------------------------------------*/
 typedef struct SST_Task SST_Task; /* forward declaration */
 
@@ -51,6 +96,20 @@ typedef uint8_t SST_TaskPrio;
 /*! SST internal event-queue counter */
 typedef uint8_t SST_QCtr;
 
+#if (SST_TASK_STATS != 0)
+/*! SST task statistics (SST_TASK_STATS), times in SST_PORT_STAT_TIME()
+* units: CPU cycles on ARM Cortex-M, ns on the host. A dispatch time runs
+* from the start to the end of the handler, so it includes preemption.
+*/
+typedef struct {
+    uint32_t nDispatch; /*!< # events dispatched to the task */
+    uint32_t runMin;    /*!< shortest dispatch time */
+    uint32_t runMax;    /*!< longest dispatch time */
+    uint64_t runTotal;  /*!< sum of all dispatch times */
+    SST_QCtr maxUsed;   /*!< queue high-water mark (max nUsed) */
+} SST_TaskStat;
+#endif
+
 /*! generic handler signature */
 typedef void (*SST_Handler)(SST_Task * const me, SST_Evt const * const e);
 
@@ -59,11 +118,13 @@ struct SST_Task {
     SST_Handler init;
     SST_Handler dispatch;
 
-    SST_Evt const **qBuf; /*!< ring buffer for the queue */
+    SST_Evt const **qBuf; /*!< ring buffer for the queue (empty entries 0) */
     SST_QCtr end;   /*!< last index into the ring buffer */
-    SST_QCtr head;  /*!< index for inserting events */
+    SST_QCtr volatile head;  /*!< index for inserting events */
     SST_QCtr tail;  /*!< index for removing events */
-    SST_QCtr nUsed; /*!< # used entries currently in the queue */
+    SST_QCtr volatile nUsed; /*!< # reserved entries in the queue */
+    SST_QCtr batch; /*!< max # events dispatched per activation */
+    uint8_t psBit;  /*!< bit of the task in the subscriber lists */
 
 #ifdef SST_PORT_TASK_ATTR
     SST_PORT_TASK_ATTR
@@ -81,10 +142,37 @@ void SST_Task_start(
     SST_Evt const **qBuf, SST_QCtr qLen,
     SST_Evt const * const ie);
 
+/* post an event to the task queue, lock-free (no critical section) so it
+* can be called from any task or ISR, including several at once
+*/
 void SST_Task_post(SST_Task * const me, SST_Evt const * const e);
 
+/* batch dispatch: drain up to 'batch' queued events per activation instead
+* of re-pending the task for every event (default 1). Higher priorities
+* still preempt between and during the dispatches.
+*/
+void SST_Task_setBatch(SST_Task * const me, SST_QCtr batch);
+
 int  SST_Task_run(void); /* run SST tasks static */
 
+#if (SST_TASK_STATS != 0)
+/* statistics of the task since it was started or last reset */
+SST_TaskStat const *SST_Task_getStat(SST_Task const * const me);
+void SST_Task_resetStat(SST_Task * const me);
+
+/* record one dispatch, called by the SST port from SST_Task_activate()
+* with the queue fill level before the event was removed
+*/
+void SST_Task_statDispatch(SST_Task * const me,
+                           SST_QCtr nUsed, uint32_t runTime);
+#define SST_TASK_STAT_BEGIN(t0_) uint32_t const t0_ = SST_PORT_STAT_TIME()
+#define SST_TASK_STAT_END(me_, nUsed_, t0_) \
+    SST_Task_statDispatch((me_), (nUsed_), SST_PORT_STAT_TIME() - (t0_))
+#else
+#define SST_TASK_STAT_BEGIN(t0_)            ((void)0)
+#define SST_TASK_STAT_END(me_, nUsed_, t0_) ((void)0)
+#endif
+
 #ifdef SST_PORT_TASK_OPER
     /* additional Task operations needed by the specific SST port */
     SST_PORT_TASK_OPER
@@ -96,18 +184,57 @@ SST_LockKey SST_Task_lock(SST_TaskPrio ceiling);
 /* unlock the SST task scheduler with the provided lock key */
 void SST_Task_unlock(SST_LockKey lock_key);
 
+/* SST Publish-Subscribe facilities ----------------------------------------*/
+/*! subscriber list of one signal
+*
+* @details
+* Bit n stands for the n-th started task in order of descending priority
+* (tasks of equal priority in the order they were started), so the lowest
+* set bit is always the highest-priority subscriber.
+*/
+typedef uint32_t SST_SubscrList;
+
+/*! max # tasks that can subscribe (bits in SST_SubscrList) */
+#define SST_PS_MAX_TASKS 32U
+
+/* provide the subscriber lists for signals 0..maxSignal-1, to be called
+* before any task is started
+*/
+void SST_PubSub_init(SST_SubscrList * const subscrSto, SST_Signal maxSignal);
+
+void SST_Task_subscribe(SST_Task const * const me, SST_Signal sig);
+void SST_Task_unsubscribe(SST_Task const * const me, SST_Signal sig);
+
+/* post the event (static or dynamic) to every subscriber of its signal,
+* the subscribers run highest priority first once all of them have it
+*/
+void SST_Task_publish(SST_Evt const * const e);
+
 /* SST Time Event facilities -----------------------------------------------*/
 /*! SST internal time-event tick counter */
 typedef uint16_t SST_TCtr;
 
+/*! number of slots in the timing wheel (power of 2)
+*
+* @details
+* Armed time events are hashed into the wheel slot of their expiry tick,
+* so SST_TimeEvt_tick() only visits the time events of the current slot.
+* Disarmed time events are not in the wheel and cost nothing per tick.
+*/
+#ifndef SST_TIMEEVT_WHEEL_SIZE
+#define SST_TIMEEVT_WHEEL_SIZE 64U
+#endif
+
 /*! SST time event class */
 typedef struct SST_TimeEvt SST_TimeEvt;
 struct SST_TimeEvt {
     SST_Evt super;
 
-    SST_TimeEvt *next; /*! link to next time event in a link-list */
+    SST_TimeEvt *next;      /*! link to next time event in the wheel slot */
+    SST_TimeEvt **prevNext; /*! link to the previous next (or slot) pointer */
+    SST_TimeEvt *expNext;   /*! link in the list of expired time events */
     SST_Task *task;    /*! the owner task to post time event to */
-    SST_TCtr ctr;      /*! time event down-counter */
+    SST_TCtr ctr;      /*! wheel turns to expiry + 1 (0 when disarmed) */
     SST_TCtr interval; /*! interval for periodic time event */
 };
 
@@ -124,12 +251,24 @@ void SST_TimeEvt_arm(
 bool SST_TimeEvt_disarm(
     SST_TimeEvt * const me);
 
-void SST_TimeEvt_tick(void); /* static handle all instantiated time events */
+void SST_TimeEvt_tick(void); /* static handle the time events due this tick */
+
+/* # ticks until the earliest armed time event expires (0 if none armed)
+* NOTE: to be called with interrupts disabled, e.g. from tickless idle
+*/
+SST_TCtr SST_TimeEvt_nextTick(void);
+
+/* process the ticks that elapsed while the tick source was suppressed
+* NOTE: to be called from the tick ISR before its own SST_TimeEvt_tick(),
+* SST_TimeEvt_tick() must never preempt itself
+*/
+void SST_TimeEvt_catchUp(SST_TCtr ticks);
 
 /* SST Kernel facilities ---------------------------------------------------*/
 void SST_init(void);
 void SST_start(void);
 void SST_onStart(void);
+void SST_onTicklessWake(SST_TCtr ticks); /* ticks skipped, from the tick ISR */
 
 /* general convenience utilities -------------------------------------------*/
 #ifndef ARRAY_NELEM
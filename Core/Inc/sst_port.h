@@ -26,10 +26,54 @@
 #ifndef SST_PORT_H_
 #define SST_PORT_H_
 
+#ifdef SST_PORT_POSIX
+/* SST port to a POSIX host, see Host/Inc/sst_port_posix.h */
+#include "sst_port_posix.h"
+#else /* ARM Cortex-M */
+
+/* per-task statistics (SST_Task_getStat), off by default on the target,
+* enable by defining SST_TASK_STATS to 1 in the compiler options
+*/
+#ifndef SST_TASK_STATS
+#define SST_TASK_STATS 0
+#endif
+
+#if (SST_TASK_STATS != 0)
+#if (__ARM_ARCH == 6) /* ARMv6-M? */
+#error "SST_TASK_STATS needs the DWT cycle counter of ARMv7-M+"
+#endif
+#define SST_PORT_TASK_STAT_ATTR SST_TaskStat stat;
+#else
+#define SST_PORT_TASK_STAT_ATTR
+#endif
+
+/* time-stamp of the task statistics: DWT cycle counter (DWT_CYCCNT) */
+#define SST_PORT_STAT_TIME() (*(uint32_t volatile *)0xE0001004U)
+
+/* context running now: the active exception number (IPSR), 16 + IRQ of
+* the running task or ISR, 0 in thread mode (main, idle)
+*/
+#define SST_PORT_CURR_CTX() SST_PORT_currCtx()
+static inline uint16_t SST_PORT_currCtx(void) {
+    uint32_t ipsr;
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return (uint16_t)(ipsr & 0x1FFU);
+}
+
+/* SST priority of the running context: the task priority of the active
+* IRQ, 0 in thread mode, SST_PORT_PRIO_ISR for the system exceptions and for
+* IRQs above all the task priorities. Contexts of the same priority never
+* preempt each other.
+*/
+#define SST_PORT_PRIO_ISR (0xFFU)
+#define SST_PORT_CURR_PRIO() SST_PORT_currPrio()
+uint8_t SST_PORT_currPrio(void);
+
 /* additional SST-PORT task attributes for ARM Cortex-M */
 #define SST_PORT_TASK_ATTR \
     uint32_t volatile *nvic_pend; \
-    uint32_t nvic_irq;
+    uint32_t nvic_irq; \
+    SST_PORT_TASK_STAT_ATTR
 
 /* additional SST-PORT task operations for ARM Cortex-M */
 #define SST_PORT_TASK_OPER \
@@ -42,15 +86,109 @@
 #define SST_PORT_CRIT_ENTRY() __asm volatile ("cpsid i")
 #define SST_PORT_CRIT_EXIT()  __asm volatile ("cpsie i")
 
+/* SST-PORT hook run once the queue entry 'head' is claimed, before the
+* event is stored into it (nothing to do on this port)
+*/
+#define SST_PORT_TASK_CLAIM() ((void)0)
+
 /* SST-PORT pend the Task after posting an event
-* NOTE: executed inside SST critical section.
+* NOTE: executed outside any critical section, after the event has been
+* stored. A single write to the NVIC set-pending register is atomic.
 */
 #define SST_PORT_TASK_PEND()  (*me->nvic_pend = me->nvic_irq)
 
+/* SST-PORT lock-free primitives of the event queues (see SST_Task_post) */
+#define SST_PORT_LOAD8(p_) (*(p_))
+#define SST_PORT_CAS8(p_, old_, new_) SST_PORT_cas8((p_), (old_), (new_))
+#define SST_PORT_EVT_STORE(p_, e_) \
+    (*(SST_Evt const * volatile *)(p_) = (e_))
+#define SST_PORT_EVT_LOAD(p_) (*(SST_Evt const * volatile *)(p_))
+
+/* compare-and-swap of a byte, returns true if *p was old and is now new_
+* NOTE: any exception taken between the exclusive load and store clears
+* the exclusive monitor, so the store fails and the caller retries.
+*/
+static inline bool SST_PORT_cas8(uint8_t volatile * const p,
+                                 uint8_t old, uint8_t new_)
+{
+#if (__ARM_ARCH == 6) /* ARMv6-M? */
+    /* NOTE: ARMv6-M (Cortex-M0/M0+/M1) has no exclusive load/store */
+    uint32_t primask;
+    bool ok = false;
+    __asm volatile ("mrs %0, primask\n cpsid i" : "=r" (primask) :: "memory");
+    if (*p == old) {
+        *p = new_;
+        ok = true;
+    }
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+    return ok;
+#else  /* ARMv7-M+ */
+    uint32_t val;
+    uint32_t fail;
+    __asm volatile ("ldrexb %0, [%1]" : "=r" (val) : "r" (p) : "memory");
+    if (val != old) {
+        __asm volatile ("clrex" ::: "memory");
+        return false;
+    }
+    __asm volatile ("strexb %0, %2, [%1]"
+                    : "=&r" (fail) : "r" (p), "r" ((uint32_t)new_) : "memory");
+    return fail == 0U;
+#endif
+}
+
+/* SST-PORT lock-free primitives of 32-bit words (see mpool_lf_t) */
+#define SST_PORT_LOAD32(p_) (*(uint32_t volatile *)(p_))
+#define SST_PORT_STORE32(p_, v_) (*(uint32_t volatile *)(p_) = (v_))
+#define SST_PORT_CAS32(p_, old_, new_) SST_PORT_cas32((p_), (old_), (new_))
+
+/* compare-and-swap of a word, returns true if *p was old and is now new_ */
+static inline bool SST_PORT_cas32(uint32_t volatile * const p,
+                                  uint32_t old, uint32_t new_)
+{
+#if (__ARM_ARCH == 6) /* ARMv6-M? */
+    uint32_t primask;
+    bool ok = false;
+    __asm volatile ("mrs %0, primask\n cpsid i" : "=r" (primask) :: "memory");
+    if (*p == old) {
+        *p = new_;
+        ok = true;
+    }
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+    return ok;
+#else  /* ARMv7-M+ */
+    uint32_t val;
+    uint32_t fail;
+    __asm volatile ("ldrex %0, [%1]" : "=r" (val) : "r" (p) : "memory");
+    if (val != old) {
+        __asm volatile ("clrex" ::: "memory");
+        return false;
+    }
+    __asm volatile ("strex %0, %2, [%1]"
+                    : "=&r" (fail) : "r" (p), "r" (new_) : "memory");
+    return fail == 0U;
+#endif
+}
+
 /* the idle SST callback for this SST port */
 void SST_onIdle(void);
 
+/* tickless idle: while idle, SysTick is reprogrammed to fire at the
+* earliest time event expiry. The skipped ticks are handed to the SysTick
+* ISR, which takes them (SST_PORT_ticklessSkipped) and reports them through
+* SST_onTicklessWake() before its own tick, so the HAL tick and the time
+* events only ever advance in that one ISR. Enable only once SysTick runs
+* at the tick rate.
+*/
+void SST_PORT_setTickless(bool enable);
+
+/* # ticks skipped by the last tickless idle, cleared by the call
+* NOTE: to be called only from the SysTick ISR
+*/
+uint32_t SST_PORT_ticklessSkipped(void);
+
 /* the SST scheduler lock key type */
 typedef uint32_t SST_LockKey;
 
+#endif /* SST_PORT_POSIX */
+
 #endif /* SST_PORT_H_ */
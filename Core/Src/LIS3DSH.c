@@ -10,6 +10,9 @@
  * a txrx request is made to the downstream SPI_manager to read the output registers of the device. The device then enters the 
  * reading state until the data has been received after which it collects the results into the devices internal structure and
  * returns to the idle state waiting for the next polling event. 
+ * Every sample read is published as a LIS3DSH_SampleEvnt_t (LIS3DSH_SAMPLE_SIG) to all
+ * subscribed tasks, so consumers don't need to poll the driver. The latest sample is also kept in
+ * a lock-free snapshot (LIS3DSH_get_sample) that any priority can read coherently.
  * @note 
  * The LIS3DSH device has to wait for a SPI_TXRXCOMPLETE_SIG or SPI_TIMEOUT_SIG before the data in its rxBuffer is valid. During a 
  * transaction no changes to the tx or rxBuffers are allows as they may be modified by the SPI_manager device. This rule prevents race 
@@ -21,13 +24,19 @@
  */
 #include "LIS3DSH.h"
 
+#include <stdatomic.h>
+
 #include "dbc_assert.h"
 #include "bsp.h"
 
 DBC_MODULE_NAME("LIS3DSH")
 
 #define LIS3DSH_DEFAULT_TIMEOUT_MS (10u)
+#define LIS3DSH_SPI_PRIORITY (SPIMANAGER_NUM_PRIOS - 1u) /*time critical sample reads go first*/
 #define LIS3DSH_MAX_INIT_ATTEMPTS (3u)
+#define LIS3DSH_SPI_RETRIES (3u) /*timeouts the SPI manager retries before the driver faults*/
+#define LIS3DSH_SPI_BACKOFF_MS (1u)
+
 #define LIS3DSH_POLL_MS (10u)
 
 /*************************Register definitions*******************/
@@ -70,6 +79,16 @@ DBC_MODULE_NAME("LIS3DSH")
 
 #define IS_A_LIS3DSH_BDU(u) (u == LIS3DSH_BDU_ENABLE || u == LIS3DSH_BDU_DISABLE)
 
+/*************************private data*******************/
+/*bus settings of the LIS3DSH, SPI mode 3 with its clock at most 10MHz: the DISC1 SPI1 runs off the
+ *84MHz APB2 so /16 (5.25MHz) is the fastest in spec (/8 would be 10.5MHz). Other slaves on the
+ *bus keep their own settings, the SPI manager switches between them*/
+static SPIManager_SlaveCfg_t const LIS3DSH_SpiCfg = {
+	.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16,
+	.CLKPolarity = SPI_POLARITY_HIGH,
+	.CLKPhase = SPI_PHASE_2EDGE,
+	.DataSize = SPI_DATASIZE_8BIT,
+};
 
 /*********************private function prototypes****************************/
 static void LIS3DSH_init_Handler(LIS3DSH_task_t *const me,
@@ -100,6 +119,10 @@ static void LIS3DSH_fault_enter(LIS3DSH_task_t *const me);
 
 static void LIS3DSH_txrx_SPI(LIS3DSH_task_t *const me, uint8_t *txData,
 		uint16_t len);
+
+static void LIS3DSH_read_SPI(LIS3DSH_task_t *const me, uint8_t reg);
+
+static void LIS3DSH_publish_sample(LIS3DSH_Sample_t const *const pSample);
 /*************************public function declarations*************************/
 
 /**
@@ -118,22 +141,39 @@ void LIS3DSH_ctor(LIS3DSH_task_t *me, SST_Task const *const SPIDeviceAO,
 
 	SST_TimeEvt_ctor(&(me->pollTimer), LIS3DSH_POLL_SIG, &(me->super));
 
-	/*link in SPI device and setup the txrx transaction event used for comms*/
+	/*link in SPI device and setup the txrx transaction job used for comms*/
 	me->SPIDeviceAO = SPIDeviceAO;
-	me->TxRxTransactionEvent.super.sig = SPI_TXRXREQ_SIG;
-	me->TxRxTransactionEvent.pJob = &(me->TxRxTransactionJob);
 	me->TxRxTransactionJob.csGPIOPin = csGPIOPin;
 	me->TxRxTransactionJob.pcsGPIOPort = pcsGPIOPort;
+	me->TxRxTransactionJob.pSlaveCfg = &LIS3DSH_SpiCfg;
 	me->TxRxTransactionJob.pAOrequester = (SST_Task const*) &(me->super);
 	me->TxRxTransactionJob.rxData = (me->spiRxBuffer); /*internal link to buffer*/
 	me->TxRxTransactionJob.txData = (me->spiTxBuffer);
 	me->TxRxTransactionJob.lenData = 0u; /*no data for now*/
 	me->TxRxTransactionJob.timeoutCnt_ms = LIS3DSH_DEFAULT_TIMEOUT_MS; /* default SPI timout*/
+	me->TxRxTransactionJob.retries = LIS3DSH_SPI_RETRIES;
+	me->TxRxTransactionJob.backoff_ms = LIS3DSH_SPI_BACKOFF_MS;
+	me->TxRxTransactionJob.priority = LIS3DSH_SPI_PRIORITY;
+	me->TxRxTransactionJob.numSegs = 0u; /*single buffer jobs, the sample read uses ReadSegs*/
+	me->TxRxTransactionJob.pSegs = NULL;
+	me->TxRxTransactionJob.pNext = NULL;
+	me->TxRxTransactionJob.pfComplete = NULL; /*responses as SPI_TXRXCOMPLETE_SIG/SPI_TIMEOUT_SIG events*/
+	me->TxRxTransactionJob.pCallbackCtx = NULL;
+	me->TxRxTransactionJob.detailedResp = 0u; /*one job in flight at a time, the bare signals do*/
+
+	/*sample read under one chip select: send the read address, then receive the 6 output
+	 *registers into spiRxBuffer[1..6] (where a single 7 byte transfer puts them)*/
+	me->ReadSegs[0] = (SPIManager_Seg_t ) { .txData = me->spiTxBuffer, .rxData = NULL,
+					.lenData = 1u };
+	me->ReadSegs[1] = (SPIManager_Seg_t ) { .txData = NULL, .rxData = &(me->spiRxBuffer[1]),
+					.lenData = 6u };
 
 	/*initial state of the device is initialising*/
 	me->DrvrState = LIS3DSH_INITIALISING;
 	me->initStage = 1; /*initial stage is one as the first stage is always performed in init handler*/
 	me->initAttempts = 0;
+	me->sampleSeq = 0;
+	me->Snapshot = (LIS3DSH_Snapshot_t){0};
 	
 	/** @todo allow additional configuration options */
 	me->ctrlReg4 = LIS3DSH_ODR_100Hz << LIS3DSH_CTRL4_ODR_POS;
@@ -142,7 +182,7 @@ void LIS3DSH_ctor(LIS3DSH_task_t *me, SST_Task const *const SPIDeviceAO,
 }
 
 /**
- * @brief LIS3DSH_get_accel_xyz - Raw read of the LIS3DSH data (results may not be from the same polling event)
+ * @brief LIS3DSH_get_accel_xyz - Read of the latest LIS3DSH data, the 3 axes always come from the same sample
  * @param me - me device pointer 
  * @return - x y z acceleration results structure LIS3DSH_Results_t
  */
@@ -150,11 +190,60 @@ LIS3DSH_Results_t LIS3DSH_get_accel_xyz(LIS3DSH_task_t * me)
 {
 	/*default configuration has full scale of 2g
 	 * this makes the fixed point format Q14*/
-	LIS3DSH_Results_t results;
-	results.x_gQ14 = me->Results.x_gQ14;
-	results.y_gQ14 = me->Results.y_gQ14;
-	results.z_gQ14 = me->Results.z_gQ14;
-	return results;
+	return LIS3DSH_snapshot_load(&(me->Snapshot)).Results;
+}
+
+/**
+ * @brief LIS3DSH_get_sample - Coherent copy of the latest sample (x y z, timestamp and sequence number).
+ * Safe to call from any task or ISR, it doesn't disable interrupts or lock the scheduler.
+ * @param me - me device pointer
+ * @return - the latest sample, all zero before the first sample or after a fault
+ */
+LIS3DSH_Sample_t LIS3DSH_get_sample(LIS3DSH_task_t const *const me)
+{
+	return LIS3DSH_snapshot_load(&(me->Snapshot));
+}
+
+/**
+ * @brief LIS3DSH_snapshot_store - Publishes a new sample into the snapshot. Each copy is written
+ * while the version sends readers to the other one, so a reader preempting this function always
+ * finds a complete sample. Only one task may store into a snapshot.
+ * @note the fences only order the compiler, which is all that is needed against preemption on a
+ * single core (an interrupt, or a signal handler on the host, sees program order)
+ * @param pSnap - snapshot to update
+ * @param pSample - new sample
+ */
+void LIS3DSH_snapshot_store(LIS3DSH_Snapshot_t *const pSnap,
+		LIS3DSH_Sample_t const *const pSample)
+{
+	pSnap->version++; /*odd: readers use copy[1]*/
+	atomic_signal_fence(memory_order_seq_cst);
+	pSnap->copy[0] = *pSample;
+	atomic_signal_fence(memory_order_seq_cst);
+	pSnap->version++; /*even: readers use copy[0]*/
+	atomic_signal_fence(memory_order_seq_cst);
+	pSnap->copy[1] = *pSample;
+}
+
+/**
+ * @brief LIS3DSH_snapshot_load - Reads a coherent sample from the snapshot. The copy selected by the
+ * version is stable unless the writer preempted this read, in which case the version has moved on
+ * and the read is retried. The writer runs to completion so a retry only repeats if yet another
+ * sample is stored during it.
+ * @param pSnap - snapshot to read
+ * @return - copy of the latest sample
+ */
+LIS3DSH_Sample_t LIS3DSH_snapshot_load(LIS3DSH_Snapshot_t const *const pSnap)
+{
+	LIS3DSH_Sample_t sample;
+	uint32_t version;
+	do {
+		version = pSnap->version;
+		atomic_signal_fence(memory_order_seq_cst);
+		sample = pSnap->copy[version & 1u];
+		atomic_signal_fence(memory_order_seq_cst);
+	} while (version != pSnap->version);
+	return sample;
 }
 
 /***************************private function declarations****************************/
@@ -316,10 +405,9 @@ static void LIS3DSH_idle_Handler(LIS3DSH_task_t *const me,
 	}
 	case LIS3DSH_POLL_SIG: {
 		/*trigger a new request for data to the device*/
-		/*txrx 7 bytes ( 1 for read instruction 6 more to get the 6 result registers into read buffer*/
+		/*1 byte read instruction then 6 more to get the 6 result registers into read buffer*/
 		me->DrvrState = LIS3DSH_READING; /*enter the reading state*/
-		uint8_t spiTxBuffer[7] = { LIS3DSH_READ | LIS3DSH_OUT_X_L };
-		LIS3DSH_txrx_SPI(me, spiTxBuffer, sizeof(spiTxBuffer));
+		LIS3DSH_read_SPI(me, LIS3DSH_OUT_X_L);
 		break;
 	}
 	default: {
@@ -341,21 +429,25 @@ static void LIS3DSH_reading_Handler(LIS3DSH_task_t *const me,
 		SST_Evt const *const e) {
 	switch (e->sig) {
 	case SPI_TXRXCOMPLETE_SIG: {
+		LIS3DSH_Sample_t sample;
 
-		me->Results.x_gQ14 = 0;
-		me->Results.x_gQ14 = (int16_t) (me->spiRxBuffer[2] << 8
+		sample.Results.x_gQ14 = (int16_t) (me->spiRxBuffer[2] << 8
 				| me->spiRxBuffer[1]);
 
-		me->Results.y_gQ14 = 0;
-		me->Results.y_gQ14 = (int16_t) (me->spiRxBuffer[4] << 8
+		sample.Results.y_gQ14 = (int16_t) (me->spiRxBuffer[4] << 8
 				| me->spiRxBuffer[3]);
 
-		me->Results.z_gQ14 = 0;
-		me->Results.z_gQ14 = (int16_t) (me->spiRxBuffer[6] << 8
+		sample.Results.z_gQ14 = (int16_t) (me->spiRxBuffer[6] << 8
 				| me->spiRxBuffer[5]);
 
+		sample.timestamp_ms = HAL_GetTick();
+		sample.seq = me->sampleSeq++;
+
 		me->DrvrState = LIS3DSH_IDLE;
 
+		LIS3DSH_snapshot_store(&(me->Snapshot), &sample);
+		LIS3DSH_publish_sample(&sample);
+
 		break;
 	}
 	case SPI_TIMEOUT_SIG: {
@@ -392,10 +484,11 @@ static void LIS3DSH_fault_Handler(LIS3DSH_task_t *const me,
  * @param me - me device pointer 
  */
 static void LIS3DSH_fault_enter(LIS3DSH_task_t *const me) {
+	LIS3DSH_Sample_t const zero = { .timestamp_ms = HAL_GetTick(), .seq =
+			me->sampleSeq };
+
 	me->DrvrState = LIS3DSH_FAULT;
-	me->Results.x_gQ14 = 0;
-	me->Results.y_gQ14 = 0;
-	me->Results.z_gQ14 = 0;
+	LIS3DSH_snapshot_store(&(me->Snapshot), &zero);
 	SST_TimeEvt_disarm(&(me->pollTimer));
 }
 
@@ -421,5 +514,39 @@ static void LIS3DSH_txrx_SPI(LIS3DSH_task_t *const me, uint8_t *txData,
 		me->spiRxBuffer[i] = 0;
 	}
 	SPIManager_post_txrx_Request((SST_Task* const ) me->SPIDeviceAO,
-			&(me->TxRxTransactionEvent));
+			SPIManager_new_txrx_Request(&(me->TxRxTransactionJob)));
+}
+
+/**
+ * @brief LIS3DSH_read_SPI - Sends a scatter-gather read request to the SPIManager: the read address
+ * from spiTxBuffer and the registers straight into spiRxBuffer[1..], no copy through a tx buffer
+ * of the full length.
+ * @note as LIS3DSH_txrx_SPI the buffers are in use until a response has been received
+ * @param me - me device pointer 
+ * @param reg - first register to read, ReadSegs sets how many
+ */
+static void LIS3DSH_read_SPI(LIS3DSH_task_t *const me, uint8_t reg) {
+	SPIManager_Job_t job = me->TxRxTransactionJob;
+
+	me->spiTxBuffer[0] = LIS3DSH_READ | reg;
+	for (uint32_t i = 0; i < me->ReadSegs[1].lenData; i++) {
+		me->ReadSegs[1].rxData[i] = 0;
+	}
+	job.numSegs = 2u;
+	job.pSegs = me->ReadSegs;
+	SPIManager_post_txrx_Request((SST_Task* const ) me->SPIDeviceAO,
+			SPIManager_new_txrx_Request(&job));
+}
+
+/**
+ * @brief LIS3DSH_publish_sample - Publishes the sample just read as a pooled LIS3DSH_SampleEvnt_t
+ * to every task subscribed to LIS3DSH_SAMPLE_SIG. All subscribers share the one event (no copy)
+ * and it is recycled once the last of them has handled it.
+ * @param pSample - sample to publish
+ */
+static void LIS3DSH_publish_sample(LIS3DSH_Sample_t const *const pSample) {
+	LIS3DSH_SampleEvnt_t *pEvt = SST_EVT_NEW(LIS3DSH_SampleEvnt_t,
+			LIS3DSH_SAMPLE_SIG);
+	pEvt->Sample = *pSample;
+	SST_Task_publish(&(pEvt->super));
 }
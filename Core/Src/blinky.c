@@ -14,30 +14,30 @@ void Blinky_ctor(BlinkyTask_T *me) {
 
 	SST_Task_ctor(&(me->super), (SST_Handler) &Blinky_initHandler,
 			(SST_Handler) &Blinky_taskHandler);
-
-	SST_TimeEvt_ctor(&(me->blinkyTimer), BLINKYTIMER, &(me->super));
-
 }
 
-/*Init handler called by SST kernel on start of the task. Arms the blinky timer with reload value of 50ms*/
+/*Init handler called by SST kernel on start of the task. Subscribes to the accelerometer samples
+ * published by the LIS3DSH task*/
 void Blinky_initHandler(BlinkyTask_T *const me, SST_Evt const *const ie) {
 	(void) ie;
-	SST_TimeEvt_arm(&(me->blinkyTimer), 1u, 50);
+	SST_Task_subscribe(&(me->super), LIS3DSH_SAMPLE_SIG);
 }
 
-/*Gets blinky task is called periodically at 50ms and sets the brighness of the four LEDS on the STM32407G-DISC1
- * board in proportion to the LIS3DSH sensors X and Y axis accelerations (psuedo level sensor)*/
+/*Blinky task is called for every published LIS3DSH sample and sets the brighness of the four LEDS
+ * on the STM32407G-DISC1 board in proportion to the sensors X and Y axis accelerations (psuedo level sensor)*/
 void Blinky_taskHandler(BlinkyTask_T *const me, SST_Evt const *const e) {
 
 	(void) me;
 
 	switch (e->sig) {
-	case BLINKYTIMER: {
+	case LIS3DSH_SAMPLE_SIG: {
 
 		/*linear scale isn't great as duty doesn't scale with brightness linearly but ok for a first go*/
 		uint_fast16_t  brightnessScale = 6; /*power of 2 for efficiency will shift by 6 places*/
 
-		LIS3DSH_Results_t xyz_accels = LIS3DSH_read();
+		/*the sample is shared with the other subscribers, read only*/
+		LIS3DSH_SampleEvnt_t const *pSample = (LIS3DSH_SampleEvnt_t const*) e;
+		LIS3DSH_Results_t xyz_accels = pSample->Sample.Results;
 
 		uint_fast16_t  xbrightnessPos = (uint_fast16_t) ((xyz_accels.x_gQ14 > 0) ? xyz_accels.x_gQ14 : 0);
 		uint_fast16_t  xbrightnessNeg = (uint_fast16_t) ((xyz_accels.x_gQ14 < 0) ? -xyz_accels.x_gQ14 : 0);
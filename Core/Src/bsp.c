@@ -12,23 +12,109 @@
 #include "tim.h"
 #include "blinky.h"
 #include "spi_manager.h"
-#include "devnt.h"
 #include "mempool.h"
 
 
 static void MX_SPI1_Init(void);
 static void MX_GPIO_Init(void);
 
+void BSP_init_event_pools(void);
 void BSP_init_SPIManager_Task(void);
 void BSP_init_blinky_task(void);
 
+/*set to 1 to suppress the 1ms SysTick while idle (wakes only for the next time event)*/
+#define BSP_TICKLESS_IDLE (0u)
+
 /*task configuration*/
 
+/*****************************Event pools************************/
+/*event pools are size classes, SST_Evt_new takes the smallest one that fits and has a free block.
+ *Tune the lengths with the per pool statistics (SST_Evt_getPoolStat)*/
+#define EVT_POOL_LEN (8u) /*dynamic events in flight at any time*/
+
+/*block size rounded up to whole pointers, so every block can hold the free list link*/
+#define EVT_BLOCK_SIZE(evt_) (((sizeof(evt_) + sizeof(void*) - 1u) \
+		/ sizeof(void*)) * sizeof(void*))
+
+/*signal only events (bare SST_Evt), so they don't take a request sized block*/
+#define SMALL_POOL_LEN (4u)
+#define SMALL_BLOCK_SIZE EVT_BLOCK_SIZE(SST_Evt)
+
+/*accelerometer samples in flight, each one is shared by all its subscribers*/
+#define SAMPLE_POOL_LEN (4u)
+#define SAMPLE_BLOCK_SIZE EVT_BLOCK_SIZE(LIS3DSH_SampleEvnt_t)
+
+static mpool_t smallPool; /*pool of signal only events*/
+static uint32_t smallPoolBuff[(SMALL_POOL_LEN * SMALL_BLOCK_SIZE)
+		/ sizeof(uint32_t)]; /*word aligned storage*/
+
+static mpool_t samplePool; /*pool of published LIS3DSH sample events*/
+static uint32_t samplePoolBuff[(SAMPLE_POOL_LEN * SAMPLE_BLOCK_SIZE)
+		/ sizeof(uint32_t)]; /*word aligned storage*/
+
+static mpool_t evtPool; /*pool of dynamic SPI manager request events*/
+static uint32_t evtPoolBuff[(EVT_POOL_LEN * sizeof(SPIManager_JobEvnt_t))
+		/ sizeof(uint32_t)]; /*word aligned storage*/
+
+void BSP_init_event_pools(void) {
+	mpool_init(&evtPool, (uint8_t*) evtPoolBuff, sizeof(evtPoolBuff),
+			sizeof(SPIManager_JobEvnt_t));
+
+	mpool_init(&samplePool, (uint8_t*) samplePoolBuff, sizeof(samplePoolBuff),
+			SAMPLE_BLOCK_SIZE);
+
+	mpool_init(&smallPool, (uint8_t*) smallPoolBuff, sizeof(smallPoolBuff),
+			SMALL_BLOCK_SIZE);
+
+	/*pools have to be added in ascending block size*/
+	SST_Evt_addPool(&smallPool, SMALL_BLOCK_SIZE, &mpool_evt_get,
+			&mpool_evt_put);
+	SST_Evt_addPool(&samplePool, SAMPLE_BLOCK_SIZE, &mpool_evt_get,
+			&mpool_evt_put);
+	SST_Evt_addPool(&evtPool, sizeof(SPIManager_JobEvnt_t), &mpool_evt_get,
+			&mpool_evt_put);
+}
+
+
+/*****************************Publish-subscribe************************/
+static SST_SubscrList subscrSto[PRJ_SIGS_MAX]; /*subscribers of each project signal*/
 
 /************************SPI task config**********************************/
 
 SPI_HandleTypeDef hspi1; /*spi device handler (initialised in HAL_SPI init functions*/
 
+/*set to 1 to drive the SPI manager transfers with DMA2 stream 0 (rx) and stream 3 (tx), channel 3,
+ *instead of an interrupt per byte*/
+#define BSP_SPI_DMA (0u)
+
+/*set to 1 to drive the SPI manager transfers with its register engine instead of the HAL: segments
+ *of up to SPIMANAGER_POLL_MAX_LEN bytes are busy-polled, longer ones run on the RXNE interrupt*/
+#define BSP_SPI_REG (0u)
+
+#if (BSP_SPI_DMA != 0u) && (BSP_SPI_REG != 0u)
+#error "BSP_SPI_DMA and BSP_SPI_REG are exclusive"
+#endif
+
+#if (BSP_SPI_DMA != 0u)
+static DMA_HandleTypeDef hdma_spi1_rx;
+static DMA_HandleTypeDef hdma_spi1_tx;
+#endif
+
+#if (SST_TASK_STATS != 0)
+/*CPU cycles spent in the SPI1 and SPI1 DMA interrupts and the number taken, divide by the bytes
+ *transferred to compare the interrupt and DMA modes (watch with the debugger)*/
+uint32_t volatile BSP_spiIsrCycles;
+uint32_t volatile BSP_spiIsrCount;
+#define BSP_SPI_ISR_BEGIN() uint32_t isrStart = SST_PORT_STAT_TIME()
+#define BSP_SPI_ISR_END() do { \
+	BSP_spiIsrCycles += SST_PORT_STAT_TIME() - isrStart; \
+	BSP_spiIsrCount++; \
+} while (0)
+#else
+#define BSP_SPI_ISR_BEGIN() ((void)0)
+#define BSP_SPI_ISR_END() ((void)0)
+#endif
+
 #define SPIMANAGER_IRQn (80u)
 #define SPIMANAGER_IRQHandler HASH_RNG_IRQHandler
 #define SPIMANAGER_TASK_PRIORITY ((SST_TaskPrio)2u)
@@ -44,6 +130,11 @@ void SPIMANAGER_IRQHandler(void) {
 
 void BSP_init_SPIManager_Task(void) {
 	SPIManager_ctor(&SpiMgrInstance, &hspi1);
+#if (BSP_SPI_REG != 0u)
+	SPIManager_set_RegEngine(&SpiMgrInstance, hspi1.Instance, SPIMANAGER_POLL_MAX_LEN);
+#elif (BSP_SPI_DMA != 0u)
+	SPIManager_set_XferMode(&SpiMgrInstance, SPI_MGR_XFER_DMA); /*DMA linked in HAL_SPI_MspInit*/
+#endif
 
 	SST_Task_setIRQ(AO_SpiMgr, SPIMANAGER_IRQn);
 
@@ -64,11 +155,43 @@ void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
 	}
 }
 
+/*transmit only segments of scatter-gather jobs*/
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	HAL_SPI_TxRxCpltCallback(hspi);
+}
+
+/*receive only segments (a full duplex master completes these as TxRx on the target)*/
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+	HAL_SPI_TxRxCpltCallback(hspi);
+}
+
 /*implement the SPI IRQ handler*/
 void SPI1_IRQHandler(void)
 {
+BSP_SPI_ISR_BEGIN();
+#if (BSP_SPI_REG != 0u)
+SPIManager_reg_IRQHandler(&SpiMgrInstance);
+#else
 HAL_SPI_IRQHandler(&hspi1);
+#endif
+BSP_SPI_ISR_END();
+}
+
+#if (BSP_SPI_DMA != 0u)
+/*SPI1 rx DMA stream, completes the transfers*/
+void DMA2_Stream0_IRQHandler(void) {
+	BSP_SPI_ISR_BEGIN();
+	HAL_DMA_IRQHandler(&hdma_spi1_rx);
+	BSP_SPI_ISR_END();
+}
+
+/*SPI1 tx DMA stream, completes transmit only transfers*/
+void DMA2_Stream3_IRQHandler(void) {
+	BSP_SPI_ISR_BEGIN();
+	HAL_DMA_IRQHandler(&hdma_spi1_tx);
+	BSP_SPI_ISR_END();
 }
+#endif
 
 /*****************************LIS3DSH Task Config************************/
 #define LIS3DSH_IRQn (DCMI_IRQn)
@@ -99,10 +222,10 @@ void BSP_init_LIS3DSH_Task(void) {
 }
 
 
-LIS3DSH_Results_t LIS3DSH_read(void)
+LIS3DSH_Sample_t LIS3DSH_read(void)
 {
-	/*unprotected read of accel data. (doesn't ensure the 3 values come from the same sample)*/
-	return LIS3DSH_get_accel_xyz(&LIS3DSHInstance);
+	/*coherent snapshot of the latest sample, safe from any priority without locking*/
+	return LIS3DSH_get_sample(&LIS3DSHInstance);
 }
 
 /*****************************Blinky Task Config************************/
@@ -132,43 +255,38 @@ void BSP_init_blinky_task(void) {
 			BLINKY_MSG_QUEUELEN, 0); /*no initial event*/
 }
 
-devnt_pool_t memPool;
-#define memPoolSize (256u)
-uint8_t memPoolBuff [256u];
+/*set to 1 to run the allocator microbenchmarks (poolbench.h) once at start up, before the tasks
+ *run. Needs SST_TASK_STATS for the cycle counter, the results are printed on the ITM (SWO) port 0*/
+#define BSP_POOL_BENCH (0u)
 
+#if (BSP_POOL_BENCH != 0u)
+#include "poolbench.h"
 
-mpool_t memPool2;
-uint8_t mPoolBuff [256u];
+#if (SST_TASK_STATS == 0)
+#error "BSP_POOL_BENCH times the allocators with the SST_TASK_STATS cycle counter"
+#endif
 
-#define BLKSIZE sizeof(SPIManager_Evnt_t)
+/*printf output (syscalls.c _write) to the ITM stimulus port 0, read it with the SWV console*/
+int __io_putchar(int ch) {
+	return (int) ITM_SendChar((uint32_t) ch);
+}
+#endif
 
 void BSP_init(void) {
 	MX_GPIO_Init();
 	MX_SPI1_Init();
 	MX_TIM4_Init();
+	BSP_init_event_pools(); /*before the tasks, which may allocate events on start*/
+	SST_PubSub_init(subscrSto, PRJ_SIGS_MAX); /*before the tasks, which may subscribe on start*/
 	BSP_init_SPIManager_Task();
 	BSP_init_blinky_task();
 	BSP_init_LIS3DSH_Task();
 
-	devnt_pool_init(&memPool, memPoolBuff, sizeof(memPoolBuff), BLKSIZE);
-
-
-	SPIManager_Evnt_t * test = (SPIManager_Evnt_t *)devnt_pool_get(&memPool, sizeof(SPIManager_Evnt_t));
-	SPIManager_Evnt_t * test1 = (SPIManager_Evnt_t *)devnt_pool_get(&memPool, sizeof(SPIManager_Evnt_t));
-	SPIManager_Evnt_t * test2 = (SPIManager_Evnt_t *)devnt_pool_get(&memPool, sizeof(SPIManager_Evnt_t));
-	SPIManager_Evnt_t * test3 = (SPIManager_Evnt_t *)devnt_pool_get(&memPool, sizeof(SPIManager_Evnt_t));
-
-	devnt_pool_put(&memPool, (void*)test2);
-	SPIManager_Evnt_t * test4 = (SPIManager_Evnt_t *)devnt_pool_get(&memPool, sizeof(SPIManager_Evnt_t));
-
-	mpool_init(&memPool2, mPoolBuff, sizeof(mPoolBuff), BLKSIZE );
-	SPIManager_Evnt_t * test5 = (SPIManager_Evnt_t *)mpool_get(&memPool2);
-	SPIManager_Evnt_t * test6 = (SPIManager_Evnt_t *)mpool_get(&memPool2);
-	SPIManager_Evnt_t * test7 = (SPIManager_Evnt_t *)mpool_get(&memPool2);
-	SPIManager_Evnt_t * test8 = (SPIManager_Evnt_t *)mpool_get(&memPool2);
-	mpool_put(&memPool2, (void*)test6);
-	SPIManager_Evnt_t * test9 = (SPIManager_Evnt_t *)mpool_get(&memPool2);
+	SST_PORT_setTickless(BSP_TICKLESS_IDLE != 0u);
 
+#if (BSP_POOL_BENCH != 0u)
+	pool_bench_run_all();
+#endif
 }
 
 
@@ -192,6 +310,16 @@ void set_green_LED_duty(uint16_t duty) {
 	TIM4->CCR1 = duty;
 }
 
+/*ticks skipped by the tickless idle, catches up the HAL tick and the SST time events as if
+ * SysTick_Handler had run for each of them. Called from SysTick_Handler before its own tick, the
+ * only place the HAL tick and the time events advance*/
+void SST_onTicklessWake(SST_TCtr ticks) {
+	for (SST_TCtr i = 0u; i < ticks; i++) {
+		HAL_IncTick();
+	}
+	SST_TimeEvt_catchUp(ticks);
+}
+
 void DBC_fault_handler(char const *const module, int const label) {
 	/*
 	 * NOTE: add here your application-specific error handling
@@ -250,7 +378,36 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef *hspi) {
 		GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
 		HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
-
+#if (BSP_SPI_DMA != 0u)
+		__HAL_RCC_DMA2_CLK_ENABLE();
+
+		hdma_spi1_rx.Instance = DMA2_Stream0;
+		hdma_spi1_rx.Init.Channel = DMA_CHANNEL_3;
+		hdma_spi1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+		hdma_spi1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+		hdma_spi1_rx.Init.MemInc = DMA_MINC_ENABLE;
+		hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		hdma_spi1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+		hdma_spi1_rx.Init.Mode = DMA_NORMAL;
+		hdma_spi1_rx.Init.Priority = DMA_PRIORITY_HIGH;
+		hdma_spi1_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+		if (HAL_DMA_Init(&hdma_spi1_rx) != HAL_OK) {
+			Error_Handler();
+		}
+		__HAL_LINKDMA(hspi, hdmarx, hdma_spi1_rx);
+
+		hdma_spi1_tx.Instance = DMA2_Stream3;
+		hdma_spi1_tx.Init = hdma_spi1_rx.Init;
+		hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+		hdma_spi1_tx.Init.Priority = DMA_PRIORITY_LOW;
+		if (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK) {
+			Error_Handler();
+		}
+		__HAL_LINKDMA(hspi, hdmatx, hdma_spi1_tx);
+
+		NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+		NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+#endif
 	}
 
 }
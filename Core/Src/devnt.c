@@ -5,51 +5,147 @@
  *      Author: Duncan
  *
  *      dynamic event pool
- *      bitfield based event pool manager, optimised for cortex m4, can only support 32 entries maximum, relies on the
+ *      bitfield based event pool manager, optimised for cortex m4. A summary word marks which of up
+ *      to 32 leaf words still have free blocks and each leaf marks 32 blocks, so a get finds a free
+ *      block with two count leading zeros (CLZ) whatever the pool size, up to 1024 blocks.
  */
 
 #include "devnt.h"
+#if (DEVNT_PORTABLE_CLZ == 0u)
 #include "cmsis_gcc.h"
+#endif
 #include "dbc_assert.h"
 #include <stddef.h>
 #include "sst.h"
 
 DBC_MODULE_NAME("devnt")
 
+/*index of the highest set bit, value must not be 0*/
+static inline uint32_t devnt_msb(uint32_t value) {
+#if (DEVNT_PORTABLE_CLZ == 0u)
+	return 31u - __CLZ(value);
+#else
+	/*binary search, for cores or compilers without a CLZ*/
+	uint32_t msb = 0u;
+	if (value >= (1u << 16)) {
+		value >>= 16;
+		msb += 16u;
+	}
+	if (value >= (1u << 8)) {
+		value >>= 8;
+		msb += 8u;
+	}
+	if (value >= (1u << 4)) {
+		value >>= 4;
+		msb += 4u;
+	}
+	if (value >= (1u << 2)) {
+		value >>= 2;
+		msb += 2u;
+	}
+	if (value >= (1u << 1)) {
+		msb += 1u;
+	}
+	return msb;
+#endif
+}
+
 void devnt_pool_init(devnt_pool_t *me, void *pMem, uint32_t memSize,
 		uint32_t blockSize) {
+	DBC_ASSERT(11u, (pMem != NULL) && (blockSize > 0u));
+
 	uint32_t numBlocks = memSize / blockSize;
 
-	DBC_ASSERT(10u, (numBlocks > 0) && (numBlocks <= 32));
-	DBC_ASSERT(11u, pMem != NULL);
+	DBC_ASSERT(10u, (numBlocks > 0) && (numBlocks <= DEVNT_MAX_BLOCKS));
 
-	/*set the free list bits with available blocks*/
-	me->freeList_bf = (uint32_t) (1 << (numBlocks)) - 1; /* shift a single bit and subtract one to fill lower bits.*/
+	/*set the free list bits with available blocks, full leaves first then the partial one*/
+	me->summary_bf = 0u;
+	for (uint32_t leaf = 0u; leaf < DEVNT_MAX_LEAVES; leaf++) {
+		uint32_t first = leaf * 32u;
+		if (first >= numBlocks) {
+			me->freeList_bf[leaf] = 0u;
+		} else {
+			uint32_t n = numBlocks - first;
+			me->freeList_bf[leaf] = (n >= 32u) ? 0xFFFFFFFFu : ((1u << n) - 1u); /* shift a single bit and subtract one to fill lower bits.*/
+			me->summary_bf |= (1u << leaf);
+		}
+	}
+	me->numBlocks = numBlocks;
 	me->pmemPool = pMem;
 	me->blockSize = blockSize;
+	POOL_STATS_INIT(me, numBlocks);
 }
 
 void* devnt_pool_get(devnt_pool_t *me, uint32_t Size) {
 	SST_PORT_CRIT_STAT
+	POOL_STATS_BEGIN(t0);
 	if (Size > me->blockSize) {
+#if (POOL_STATS != 0)
+		SST_PORT_CRIT_ENTRY();
+		POOL_STATS_GET(me, -1, t0);
+		SST_PORT_CRIT_EXIT();
+#endif
 		return NULL;
 	}
 
 	SST_PORT_CRIT_ENTRY();
 
-	uint_fast8_t nextFreeBit = (31u - __CLZ (me->freeList_bf)); /*find a free entry*/
-	me->freeList_bf &= ~(uint32_t) (1 << nextFreeBit); /*clear the bit as used, we can now leave the critical section*/
+	if (me->summary_bf == 0u) { /*pool empty*/
+		POOL_STATS_GET(me, -1, t0);
+		SST_PORT_CRIT_EXIT();
+		return NULL;
+	}
+	uint32_t leaf = devnt_msb(me->summary_bf); /*find a leaf with a free entry*/
+	uint32_t bit = devnt_msb(me->freeList_bf[leaf]); /*find a free entry*/
+	me->freeList_bf[leaf] &= ~(1u << bit); /*clear the bit as used*/
+	if (me->freeList_bf[leaf] == 0u) {
+		me->summary_bf &= ~(1u << leaf); /*leaf used up*/
+	}
+	POOL_STATS_GET(me, (int32_t) ((leaf * 32u) + bit), t0);
 
-	SST_PORT_CRIT_EXIT();
+	SST_PORT_CRIT_EXIT(); /*we can now leave the critical section*/
 
-	return (void*) (me->pmemPool + (nextFreeBit * me->blockSize));
+	return (void*) (me->pmemPool + (((leaf * 32u) + bit) * me->blockSize));
 }
 
 void devnt_pool_put(devnt_pool_t *me, uint8_t *block) {
+	SST_PORT_CRIT_STAT
+	POOL_STATS_BEGIN(t0);
+	uint32_t offset = (uint32_t) (block - me->pmemPool);
+	uint32_t blockNum = offset / me->blockSize;
+
+	/*block must be from this pool*/
+	DBC_ASSERT(20u, (block >= me->pmemPool) && (blockNum < me->numBlocks)
+			&& ((offset % me->blockSize) == 0u));
+
+	uint32_t leaf = blockNum / 32u;
+	uint32_t mask = 1u << (blockNum % 32u);
 
 	SST_PORT_CRIT_ENTRY();
-	uint8_t blockBit = (uint8_t) ((uint32_t) (block - me->pmemPool)
-			/ me->blockSize);
-	me->freeList_bf |= (uint32_t) (1 << blockBit); /*set the bit as unused, we can now leave the critical section*/
+	DBC_ASSERT(21u, (me->freeList_bf[leaf] & mask) == 0u); /*not already free*/
+	me->freeList_bf[leaf] |= mask; /*set the bit as unused*/
+	me->summary_bf |= (1u << leaf);
+	POOL_STATS_PUT(me, blockNum, t0);
+	SST_PORT_CRIT_EXIT(); /*we can now leave the critical section*/
+}
+
+#if (POOL_STATS != 0)
+pool_stats_t const* devnt_pool_get_stats(devnt_pool_t const *me) {
+	return &(me->stats);
+}
+
+void devnt_pool_reset_stats(devnt_pool_t *me) {
+	SST_PORT_CRIT_STAT
+	SST_PORT_CRIT_ENTRY();
+	pool_stats_reset(&(me->stats));
 	SST_PORT_CRIT_EXIT();
 }
+#endif
+
+void* devnt_pool_evt_get(void *const me, uint32_t size) {
+	return devnt_pool_get((devnt_pool_t*) me, size);
+}
+
+void devnt_pool_evt_put(void *const me, void *const block) {
+	devnt_pool_put((devnt_pool_t*) me, (uint8_t*) block);
+}
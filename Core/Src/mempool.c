@@ -20,44 +20,267 @@ void mpool_init(mpool_t *me, uint8_t *pMem, uint32_t memSize,
 	DBC_ASSERT(10u, (numBlocks > 0));
 	DBC_ASSERT(11u, pMem != NULL);
 
-	me->head = (mpool_empty_t*) pMem;
-
-	uint8_t *ptr = pMem;
-	while (ptr < (pMem + (memSize - blockSize)))
-	{
-		((mpool_empty_t *)ptr)->next = (mpool_empty_t *)(ptr + blockSize);
-		ptr = ptr + blockSize;
-	}
-
-	((mpool_empty_t *)ptr)->next =NULL;
+	/*O(1), blocks are linked lazily when they are first put back*/
+	me->head = NULL;
+	me->bump = pMem;
+	me->end = pMem + (numBlocks * blockSize);
+	me->pmemPool = pMem;
 	me->free = numBlocks;
 	me->blocksize = blockSize;
+	POOL_STATS_INIT(me, numBlocks);
 }
 
 void* mpool_get(mpool_t *me) {
 	SST_PORT_CRIT_STAT
 	void *result = NULL;
+	POOL_STATS_BEGIN(t0);
 
 	SST_PORT_CRIT_ENTRY();
 
-	if (me->free > 0u) {  /*if we have free values in the list*/
+	if (me->head != NULL) {  /*reuse a block that was put back first, it is likely still cached*/
 		result = (void*) me->head;
+		me->head = me->head->next;
+		me->free--;
+	} else if (me->bump < me->end) { /*then one never used*/
+		result = (void*) me->bump;
+		me->bump += me->blocksize;
 		me->free--;
-		if (me->free > 0) {
-			me->head = me->head->next;
-		} else {
-			me->head = NULL;
-		}
 	}
+	POOL_STATS_GET(me, (result != NULL) ?
+			(int32_t) ((uint32_t) ((uint8_t*) result - me->pmemPool) / me->blocksize) : -1, t0);
 	SST_PORT_CRIT_EXIT();
 	return result;
 }
 
 void mpool_put(mpool_t *me, uint8_t *block) {
 	SST_PORT_CRIT_STAT
+	POOL_STATS_BEGIN(t0);
 	SST_PORT_CRIT_ENTRY();
 	((mpool_empty_t*) block)->next = me->head;
 	me->head = (mpool_empty_t*) block;
 	me->free++;
+	POOL_STATS_PUT(me, (uint32_t) (block - me->pmemPool) / me->blocksize, t0);
+	SST_PORT_CRIT_EXIT();
+}
+
+uint32_t mpool_get_batch(mpool_t *me, void **blocks, uint32_t n) {
+	SST_PORT_CRIT_STAT
+	uint32_t got = 0u;
+	POOL_STATS_BEGIN(t0);
+
+	SST_PORT_CRIT_ENTRY();
+	while (got < n) {
+		void *block;
+		if (me->head != NULL) {
+			block = (void*) me->head;
+			me->head = me->head->next;
+		} else if (me->bump < me->end) {
+			block = (void*) me->bump;
+			me->bump += me->blocksize;
+		} else {
+			break;
+		}
+		me->free--;
+		blocks[got++] = block;
+		POOL_STATS_GET(me,
+				(int32_t) ((uint32_t) ((uint8_t*) block - me->pmemPool) / me->blocksize), t0);
+	}
+	if (got < n) {
+		POOL_STATS_GET(me, -1, t0);
+	}
+	SST_PORT_CRIT_EXIT();
+	return got;
+}
+
+void mpool_put_batch(mpool_t *me, void *const *blocks, uint32_t n) {
+	SST_PORT_CRIT_STAT
+	POOL_STATS_BEGIN(t0);
+
+	SST_PORT_CRIT_ENTRY();
+	for (uint32_t i = 0u; i < n; i++) {
+		mpool_empty_t *block = (mpool_empty_t*) blocks[i];
+		block->next = me->head;
+		me->head = block;
+		me->free++;
+		POOL_STATS_PUT(me, (uint32_t) ((uint8_t*) block - me->pmemPool) / me->blocksize, t0);
+	}
+	SST_PORT_CRIT_EXIT();
+}
+
+uint32_t mpool_max_used(mpool_t const *me) {
+	/*the bump pointer only moves when every block handed out before is in use*/
+	return (uint32_t) (me->bump - me->pmemPool) / me->blocksize;
+}
+
+#if (POOL_STATS != 0)
+pool_stats_t const* mpool_get_stats(mpool_t const *me) {
+	return &(me->stats);
+}
+
+void mpool_reset_stats(mpool_t *me) {
+	SST_PORT_CRIT_STAT
+	SST_PORT_CRIT_ENTRY();
+	pool_stats_reset(&(me->stats));
 	SST_PORT_CRIT_EXIT();
 }
+#endif
+
+void* mpool_evt_get(void *const me, uint32_t size) {
+	DBC_ASSERT(20u, size <= ((mpool_t*) me)->blocksize);
+	return mpool_get((mpool_t*) me);
+}
+
+void mpool_evt_put(void *const me, void *const block) {
+	mpool_put((mpool_t*) me, (uint8_t*) block);
+}
+
+/*****************************magazine cache************************/
+void mpool_cache_init(mpool_cache_t *me, mpool_t *pool) {
+	DBC_ASSERT(60u, pool != NULL);
+
+	me->pool = pool;
+	for (uint32_t i = 0u; i < MPOOL_MAG_LEVELS; i++) {
+		me->mag[i].n = 0u;
+		me->mag[i].nRefill = 0u;
+		me->mag[i].nFlush = 0u;
+	}
+}
+
+void* mpool_cache_get_at(mpool_cache_t *me, uint8_t prio) {
+	if (prio >= MPOOL_MAG_LEVELS) {
+		return mpool_get(me->pool);
+	}
+	/*no critical section, only this priority level uses the magazine*/
+	mpool_mag_t *mag = &me->mag[prio];
+	if (mag->n == 0u) {
+		mag->n = mpool_get_batch(me->pool, mag->blocks, MPOOL_MAG_BATCH);
+		mag->nRefill++;
+		if (mag->n == 0u) { /*pool empty (or its blocks are in other magazines)*/
+			return NULL;
+		}
+	}
+	return mag->blocks[--mag->n];
+}
+
+void mpool_cache_put_at(mpool_cache_t *me, uint8_t *block, uint8_t prio) {
+	if (prio >= MPOOL_MAG_LEVELS) {
+		mpool_put(me->pool, block);
+		return;
+	}
+	mpool_mag_t *mag = &me->mag[prio];
+	if (mag->n == MPOOL_MAG_SIZE) { /*full, give the oldest half back*/
+		mpool_put_batch(me->pool, mag->blocks, MPOOL_MAG_BATCH);
+		for (uint32_t i = MPOOL_MAG_BATCH; i < MPOOL_MAG_SIZE; i++) {
+			mag->blocks[i - MPOOL_MAG_BATCH] = mag->blocks[i];
+		}
+		mag->n -= MPOOL_MAG_BATCH;
+		mag->nFlush++;
+	}
+	mag->blocks[mag->n++] = block;
+}
+
+void* mpool_cache_get(mpool_cache_t *me) {
+	return mpool_cache_get_at(me, SST_PORT_CURR_PRIO());
+}
+
+void mpool_cache_put(mpool_cache_t *me, uint8_t *block) {
+	mpool_cache_put_at(me, block, SST_PORT_CURR_PRIO());
+}
+
+void mpool_cache_flush(mpool_cache_t *me) {
+	uint8_t prio = SST_PORT_CURR_PRIO();
+	if (prio < MPOOL_MAG_LEVELS) {
+		mpool_mag_t *mag = &me->mag[prio];
+		mpool_put_batch(me->pool, mag->blocks, mag->n);
+		mag->n = 0u;
+	}
+}
+
+void* mpool_cache_evt_get(void *const me, uint32_t size) {
+	DBC_ASSERT(61u, size <= ((mpool_cache_t*) me)->pool->blocksize);
+	return mpool_cache_get((mpool_cache_t*) me);
+}
+
+void mpool_cache_evt_put(void *const me, void *const block) {
+	mpool_cache_put((mpool_cache_t*) me, (uint8_t*) block);
+}
+
+/*****************************lock-free pool************************/
+/*a free block holds the index + 1 of the next free block (0 at the end) in its first word*/
+static inline uint32_t volatile* mpool_lf_link(mpool_lf_t *me, uint32_t idx) {
+	return (uint32_t volatile*) (me->pmemPool + (idx * me->blocksize));
+}
+
+static void mpool_lf_add_free(mpool_lf_t *me, uint32_t delta) {
+	uint32_t free;
+	do {
+		free = SST_PORT_LOAD32(&me->free);
+	} while (!SST_PORT_CAS32(&me->free, free, free + delta));
+}
+
+void mpool_lf_init(mpool_lf_t *me, uint8_t *pMem, uint32_t memSize,
+		uint32_t blockSize) {
+
+	uint32_t numBlocks = (uint32_t) (memSize / blockSize);
+
+	DBC_ASSERT(30u, (numBlocks > 0) && (numBlocks <= MPOOL_LF_IDX_MSK));
+	DBC_ASSERT(31u, (pMem != NULL) && (((uintptr_t) pMem % sizeof(uint32_t)) == 0u));
+	DBC_ASSERT(32u, (blockSize % sizeof(uint32_t)) == 0u); /*every link word aligned*/
+
+	me->pmemPool = pMem;
+	me->blocksize = blockSize;
+	me->numBlocks = numBlocks;
+	for (uint32_t idx = 0; idx < numBlocks; idx++) {
+		*mpool_lf_link(me, idx) = ((idx + 1u) < numBlocks) ? (idx + 2u) : 0u; /*next block's index + 1*/
+	}
+	me->free = numBlocks;
+	me->head = 1u; /*generation 0, first block*/
+}
+
+void* mpool_lf_get(mpool_lf_t *me) {
+	uint32_t head;
+	uint32_t idx;
+	uint32_t next;
+
+	do {
+		head = SST_PORT_LOAD32(&me->head);
+		idx = head & MPOOL_LF_IDX_MSK;
+		if (idx == 0u) { /*pool empty*/
+			return NULL;
+		}
+		/*if the block was taken meanwhile this link is stale, but then the generation has
+		 * moved on and the swap fails*/
+		next = SST_PORT_LOAD32(mpool_lf_link(me, idx - 1u));
+	} while (!SST_PORT_CAS32(&me->head, head,
+			((head & ~MPOOL_LF_IDX_MSK) + MPOOL_LF_GEN_INC) | next));
+
+	mpool_lf_add_free(me, (uint32_t) -1);
+	return (void*) (me->pmemPool + ((idx - 1u) * me->blocksize));
+}
+
+void mpool_lf_put(mpool_lf_t *me, uint8_t *block) {
+	uint32_t offset = (uint32_t) (block - me->pmemPool);
+	uint32_t idx = (offset / me->blocksize) + 1u;
+	uint32_t head;
+
+	/*block must be from this pool*/
+	DBC_ASSERT(40u, (block >= me->pmemPool) && (idx <= me->numBlocks)
+			&& ((offset % me->blocksize) == 0u));
+
+	do {
+		head = SST_PORT_LOAD32(&me->head);
+		SST_PORT_STORE32(mpool_lf_link(me, idx - 1u), head & MPOOL_LF_IDX_MSK);
+	} while (!SST_PORT_CAS32(&me->head, head,
+			((head & ~MPOOL_LF_IDX_MSK) + MPOOL_LF_GEN_INC) | idx));
+
+	mpool_lf_add_free(me, 1u);
+}
+
+void* mpool_lf_evt_get(void *const me, uint32_t size) {
+	DBC_ASSERT(50u, size <= ((mpool_lf_t*) me)->blocksize);
+	return mpool_lf_get((mpool_lf_t*) me);
+}
+
+void mpool_lf_evt_put(void *const me, void *const block) {
+	mpool_lf_put((mpool_lf_t*) me, (uint8_t*) block);
+}
@@ -0,0 +1,255 @@
+/*
+ * poolbench.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Allocator microbenchmarks, see poolbench.h
+ */
+
+#include "poolbench.h"
+#include "mempool.h"
+#include "devnt.h"
+#include <stdio.h>
+#if (POOL_BENCH_MALLOC != 0u)
+#include <stdlib.h>
+#endif
+
+#if (SST_TASK_STATS != 0)
+
+#if (POOL_BENCH_MAX_BLOCKS > DEVNT_MAX_BLOCKS)
+#error "POOL_BENCH_MAX_BLOCKS is larger than a devnt pool (DEVNT_MAX_BLOCKS)"
+#endif
+
+#ifdef SST_PORT_POSIX
+#define POOL_BENCH_TIME_UNIT "ns"
+#else
+#define POOL_BENCH_TIME_UNIT "cycles"
+#endif
+
+static uint64_t poolBenchBuff[(POOL_BENCH_MAX_BLOCKS * POOL_BENCH_BLOCK_SIZE) / sizeof(uint64_t)];
+static void *poolBenchHeld[POOL_BENCH_MAX_BLOCKS]; /*blocks the pattern holds, a ring for FIFO*/
+
+static mpool_t poolBenchMpool;
+static mpool_lf_t poolBenchMpoolLf;
+static devnt_pool_t poolBenchDevnt;
+
+static void pool_bench_mpool_init(void *const pool, uint8_t *pMem, uint32_t memSize,
+		uint32_t blockSize) {
+	mpool_init((mpool_t*) pool, pMem, memSize, blockSize);
+}
+
+static void pool_bench_mpool_lf_init(void *const pool, uint8_t *pMem, uint32_t memSize,
+		uint32_t blockSize) {
+	mpool_lf_init((mpool_lf_t*) pool, pMem, memSize, blockSize);
+}
+
+static void pool_bench_devnt_init(void *const pool, uint8_t *pMem, uint32_t memSize,
+		uint32_t blockSize) {
+	devnt_pool_init((devnt_pool_t*) pool, pMem, memSize, blockSize);
+}
+
+#if (POOL_BENCH_MALLOC != 0u)
+/*malloc has no pool, init and the pool pointer are unused*/
+static void pool_bench_malloc_init(void *const pool, uint8_t *pMem, uint32_t memSize,
+		uint32_t blockSize) {
+	(void) pool;
+	(void) pMem;
+	(void) memSize;
+	(void) blockSize;
+}
+
+static void* pool_bench_malloc_get(void *const pool, uint32_t size) {
+	(void) pool;
+	return malloc(size);
+}
+
+static void pool_bench_malloc_put(void *const pool, void *const block) {
+	(void) pool;
+	free(block);
+}
+#endif
+
+static pool_bench_alloc_t const poolBenchAllocs[] = {
+	{ "mpool", &pool_bench_mpool_init, &mpool_evt_get, &mpool_evt_put, &poolBenchMpool },
+	{ "mpool_lf", &pool_bench_mpool_lf_init, &mpool_lf_evt_get, &mpool_lf_evt_put, &poolBenchMpoolLf },
+	{ "devnt", &pool_bench_devnt_init, &devnt_pool_evt_get, &devnt_pool_evt_put, &poolBenchDevnt },
+#if (POOL_BENCH_MALLOC != 0u)
+	{ "malloc", &pool_bench_malloc_init, &pool_bench_malloc_get, &pool_bench_malloc_put, NULL },
+#endif
+};
+
+static char const *const poolBenchPatterns[POOL_BENCH_NUM_PATTERNS] = {
+	"lifo", "fifo", "random", "bursty"
+};
+
+/*xorshift32, the same sequence on every run and target*/
+static uint32_t pool_bench_rand(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static void pool_bench_lifo(pool_bench_alloc_t const *alloc, uint32_t numBlocks,
+		pool_bench_result_t *res) {
+	while (res->ops < POOL_BENCH_OPS) {
+		for (uint32_t i = 0u; i < numBlocks; i++) {
+			poolBenchHeld[i] = alloc->get(alloc->pool, POOL_BENCH_BLOCK_SIZE);
+			res->nFail += (poolBenchHeld[i] == NULL) ? 1u : 0u;
+		}
+		for (uint32_t i = numBlocks; i > 0u; i--) {
+			if (poolBenchHeld[i - 1u] != NULL) {
+				alloc->put(alloc->pool, poolBenchHeld[i - 1u]);
+			}
+		}
+		res->ops += 2u * numBlocks;
+	}
+}
+
+static void pool_bench_fifo(pool_bench_alloc_t const *alloc, uint32_t numBlocks,
+		pool_bench_result_t *res) {
+	uint32_t depth = numBlocks / 2u;
+	uint32_t head = 0u; /*oldest held block*/
+
+	for (uint32_t i = 0u; i < depth; i++) {
+		poolBenchHeld[i] = alloc->get(alloc->pool, POOL_BENCH_BLOCK_SIZE);
+	}
+	res->ops += depth;
+	while (res->ops < POOL_BENCH_OPS) {
+		uint32_t tail = (head + depth) % numBlocks;
+		poolBenchHeld[tail] = alloc->get(alloc->pool, POOL_BENCH_BLOCK_SIZE);
+		res->nFail += (poolBenchHeld[tail] == NULL) ? 1u : 0u;
+		if (poolBenchHeld[head] != NULL) {
+			alloc->put(alloc->pool, poolBenchHeld[head]);
+		}
+		head = (head + 1u) % numBlocks;
+		res->ops += 2u;
+	}
+	for (uint32_t i = 0u; i < depth; i++) {
+		if (poolBenchHeld[(head + i) % numBlocks] != NULL) {
+			alloc->put(alloc->pool, poolBenchHeld[(head + i) % numBlocks]);
+		}
+	}
+	res->ops += depth;
+}
+
+static void pool_bench_random(pool_bench_alloc_t const *alloc, uint32_t numBlocks,
+		pool_bench_result_t *res) {
+	uint32_t rand = 0x2545F491u;
+	uint32_t held = 0u;
+
+	for (; res->ops < POOL_BENCH_OPS; res->ops++) {
+		uint32_t r = pool_bench_rand(&rand);
+		if ((held == 0u) || ((held < numBlocks) && ((r & 1u) != 0u))) {
+			void *block = alloc->get(alloc->pool, POOL_BENCH_BLOCK_SIZE);
+			if (block != NULL) {
+				poolBenchHeld[held++] = block;
+			} else {
+				res->nFail++;
+			}
+		} else { /*free a random held block, the last one takes its place*/
+			uint32_t i = (r >> 1) % held;
+			alloc->put(alloc->pool, poolBenchHeld[i]);
+			poolBenchHeld[i] = poolBenchHeld[--held];
+		}
+	}
+	while (held > 0u) {
+		alloc->put(alloc->pool, poolBenchHeld[--held]);
+		res->ops++;
+	}
+}
+
+static void pool_bench_bursty(pool_bench_alloc_t const *alloc, uint32_t numBlocks,
+		pool_bench_result_t *res) {
+	uint32_t rand = 0x9E3779B9u;
+
+	while (res->ops < POOL_BENCH_OPS) {
+		uint32_t burst = 1u + (pool_bench_rand(&rand) % numBlocks);
+		for (uint32_t i = 0u; i < burst; i++) {
+			poolBenchHeld[i] = alloc->get(alloc->pool, POOL_BENCH_BLOCK_SIZE);
+			res->nFail += (poolBenchHeld[i] == NULL) ? 1u : 0u;
+		}
+		for (uint32_t i = 0u; i < burst; i++) {
+			if (poolBenchHeld[i] != NULL) {
+				alloc->put(alloc->pool, poolBenchHeld[i]);
+			}
+		}
+		res->ops += 2u * burst;
+	}
+}
+
+/*a fixed block pool has no fragmentation: once the pattern has freed everything, all numBlocks
+ *blocks can be held again whatever order they were got and freed in*/
+static uint32_t pool_bench_fill(pool_bench_alloc_t const *alloc, uint32_t numBlocks) {
+	uint32_t fill = 0u;
+	while (fill < numBlocks) {
+		void *block = alloc->get(alloc->pool, POOL_BENCH_BLOCK_SIZE);
+		if (block == NULL) {
+			break;
+		}
+		poolBenchHeld[fill++] = block;
+	}
+	for (uint32_t i = fill; i > 0u; i--) {
+		alloc->put(alloc->pool, poolBenchHeld[i - 1u]);
+	}
+	return fill;
+}
+
+pool_bench_result_t pool_bench_run(pool_bench_alloc_t const *alloc, pool_bench_pattern_t pattern,
+		uint32_t numBlocks) {
+	pool_bench_result_t res = { 0 };
+
+	if (numBlocks > POOL_BENCH_MAX_BLOCKS) {
+		numBlocks = POOL_BENCH_MAX_BLOCKS;
+	}
+	alloc->init(alloc->pool, (uint8_t*) poolBenchBuff, numBlocks * POOL_BENCH_BLOCK_SIZE,
+			POOL_BENCH_BLOCK_SIZE);
+
+	/*the pattern bookkeeping is in the time too, it is the same for every allocator*/
+	uint32_t t0 = SST_PORT_STAT_TIME();
+	switch (pattern) {
+	case POOL_BENCH_LIFO:
+		pool_bench_lifo(alloc, numBlocks, &res);
+		break;
+	case POOL_BENCH_FIFO:
+		pool_bench_fifo(alloc, numBlocks, &res);
+		break;
+	case POOL_BENCH_RANDOM:
+		pool_bench_random(alloc, numBlocks, &res);
+		break;
+	default:
+		pool_bench_bursty(alloc, numBlocks, &res);
+		break;
+	}
+	res.time = SST_PORT_STAT_TIME() - t0;
+
+	res.fill = pool_bench_fill(alloc, numBlocks);
+	return res;
+}
+
+void pool_bench_run_all(void) {
+	static uint32_t const sizes[] = { 32u, POOL_BENCH_MAX_BLOCKS };
+
+	for (uint32_t s = 0u; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (uint32_t a = 0u; a < sizeof(poolBenchAllocs) / sizeof(poolBenchAllocs[0]); a++) {
+			for (uint32_t p = 0u; p < POOL_BENCH_NUM_PATTERNS; p++) {
+				pool_bench_result_t res = pool_bench_run(&poolBenchAllocs[a],
+						(pool_bench_pattern_t) p, sizes[s]);
+				/*hundredths in integers, the target printf has no floats*/
+				uint32_t perOp100 = (uint32_t) (((uint64_t) res.time * 100u) / res.ops);
+				printf("bench=alloc alloc=%s pattern=%s blocks=%lu ops=%lu per_op=%lu.%02lu unit="
+						POOL_BENCH_TIME_UNIT " fail=%lu fill=%lu frag_free=%u\n",
+						poolBenchAllocs[a].name, poolBenchPatterns[p], (unsigned long) sizes[s],
+						(unsigned long) res.ops, (unsigned long) (perOp100 / 100u),
+						(unsigned long) (perOp100 % 100u), (unsigned long) res.nFail,
+						(unsigned long) res.fill,
+						((res.nFail == 0u) && (res.fill == sizes[s])) ? 1u : 0u);
+			}
+		}
+	}
+}
+
+#endif /* SST_TASK_STATS */
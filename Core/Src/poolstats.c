@@ -0,0 +1,99 @@
+/*
+ * poolstats.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Allocator instrumentation shared by mempool.c and devnt.c, see poolstats.h
+ */
+
+#include "poolstats.h"
+
+#if (POOL_STATS != 0)
+
+#include "cmsis_gcc.h"
+
+static void pool_stats_hist(uint32_t *hist, uint32_t time) {
+	uint32_t bin = 32u - __CLZ(time); /*0 for a time of 0, n for [2^(n-1), 2^n)*/
+	if (bin >= POOL_STATS_HIST_BINS) {
+		bin = POOL_STATS_HIST_BINS - 1u;
+	}
+	hist[bin]++;
+}
+
+/*index of the running task or ISR in the owner table, claims a free entry for a new owner.
+ * -1 when the table is full*/
+static int32_t pool_stats_owner(pool_stats_t *me) {
+	uint16_t ctx = SST_PORT_CURR_CTX();
+	for (uint32_t i = 0; i < POOL_STATS_MAX_OWNERS; i++) {
+		if (me->owner[i].ctx == ctx) {
+			return (int32_t) i;
+		}
+		if (me->owner[i].ctx == POOL_STATS_NO_OWNER) {
+			me->owner[i].ctx = ctx;
+			return (int32_t) i;
+		}
+	}
+	return -1;
+}
+
+void pool_stats_init(pool_stats_t *me, uint32_t numBlocks) {
+	*me = (pool_stats_t ) { 0 };
+	me->numBlocks = numBlocks;
+	me->minFree = numBlocks;
+	for (uint32_t i = 0; i < POOL_STATS_MAX_OWNERS; i++) {
+		me->owner[i].ctx = POOL_STATS_NO_OWNER;
+	}
+}
+
+void pool_stats_reset(pool_stats_t *me) {
+	me->minFree = me->numBlocks - me->used;
+	me->nGet = 0u;
+	me->nFail = 0u;
+	me->nPut = 0u;
+	for (uint32_t i = 0; i < POOL_STATS_MAX_OWNERS; i++) {
+		me->owner[i].peak = me->owner[i].used;
+	}
+	for (uint32_t i = 0; i < POOL_STATS_HIST_BINS; i++) {
+		me->getHist[i] = 0u;
+		me->putHist[i] = 0u;
+	}
+}
+
+void pool_stats_get(pool_stats_t *me, int32_t blockIdx, uint32_t time) {
+	pool_stats_hist(me->getHist, time);
+	if (blockIdx < 0) {
+		me->nFail++;
+		return;
+	}
+	me->nGet++;
+	me->used++;
+	if ((me->numBlocks - me->used) < me->minFree) {
+		me->minFree = me->numBlocks - me->used;
+	}
+	if ((uint32_t) blockIdx < POOL_STATS_MAX_BLOCKS) {
+		int32_t owner = pool_stats_owner(me);
+		me->blockOwner[blockIdx] = (uint8_t) (owner + 1);
+		if (owner >= 0) {
+			pool_owner_stats_t *pOwner = &me->owner[owner];
+			if (++pOwner->used > pOwner->peak) {
+				pOwner->peak = pOwner->used;
+			}
+		}
+	}
+}
+
+void pool_stats_put(pool_stats_t *me, uint32_t blockIdx, uint32_t time) {
+	pool_stats_hist(me->putHist, time);
+	me->nPut++;
+	me->used--;
+	if (blockIdx < POOL_STATS_MAX_BLOCKS) {
+		uint8_t owner = me->blockOwner[blockIdx];
+		if (owner != 0u) {
+			me->owner[owner - 1u].used--;
+			me->blockOwner[blockIdx] = 0u;
+		}
+	}
+}
+
+#endif /* POOL_STATS */
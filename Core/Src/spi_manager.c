@@ -4,15 +4,39 @@
  * @brief   This file provides code for managing a single SPI device
  ******************************************************************************
  * The SPI manager provides methods to share a SPI device via a single interfacing task.
- * THe driver depends on the STM32 SPI (Interrupt mode) and GPIO HAL drivers.
+ * THe driver depends on the STM32 SPI (Interrupt or DMA mode, see SPIManager_set_XferMode) and GPIO HAL drivers.
  * Implemented via an event driven state machine (built with a switch case and state variable)
  * with two states, SPI_MGR_BUSY and SPI_MGR_READY.
- * The manager contains an internal queue of SPIMANAGER_QUEUE_SIZE SPI transactions.
+ * The manager contains an internal queue of SPIMANAGER_QUEUE_SIZE SPI transactions, a FIFO per
+ * job priority with a bitmap of the priorities that have jobs waiting. The highest priority starts
+ * next, unless a lower priority has waited SPIMANAGER_AGING_LIMIT jobs (aging).
  * It will provide event callbacks to the threads which request SPI jobs so these threads
  * need to implement handlers for the SPI_TXRXCOMPLETE_SIG and SPI_TIMEOUT_SIG event signals
  * When a job is provided to the spi manager it is expected that the contents of the tx and
  * rx buffers in the request message remain untouched and valid  before the 
  * SPI_TXRXCOMPLETE_SIG response is received from the manager.
+ * Requests allocated with SPIManager_new_txrx_Request carry their own copy of the job and are
+ * recycled by the manager when the job finishes, static requests must keep their job valid.
+ * A job may be a list of segments (pSegs), e.g. a register address from one buffer and the
+ * payload into another, clocked one after the other while its chip select stays low. Jobs can
+ * be chained (pNext): the next job of the chain starts as soon as the previous one finishes,
+ * with the chip select raised in between, and the requester of the first job gets a single
+ * response for the whole chain. Segment lists and chained jobs must stay valid like the buffers.
+ * A job with a completion callback (pfComplete) gets no response event: the callback runs in the
+ * manager task as soon as the job (chain) has finished or timed out, which saves the post and the
+ * switch to the requester for e.g. decoding a sample into a lock-free buffer.
+ * A job with detailedResp set gets its request event back as the response, stamped with a sequence
+ * number, the status and the bus time, so a requester can pipeline several jobs (each with its own
+ * buffers) and match the responses to them.
+ * The register engine (SPI_MGR_XFER_REG) bypasses the HAL: segments of up to pollMaxLen bytes are
+ * clocked by polling the SPI status register inside the manager task and complete without any
+ * interrupt or completion event, longer segments run a byte per RXNE interrupt
+ * (SPIManager_reg_IRQHandler, called from the SPI IRQ handler instead of HAL_SPI_IRQHandler).
+ * A job that times out is aborted with its chip select raised and the next queued job starts. It
+ * is retried up to its retries count, after a backoff (backoff_ms, doubled for each retry) during
+ * which other jobs use the bus, and only the last timeout is reported to the requester.
+ * Each job may name the bus settings of its slave (pSlaveCfg: prescaler, CPOL/CPHA and data size),
+ * the SPI is reconfigured between jobs, with the chip selects high, only when they change.
  * @note 
  * The user needs to post TxRx complete signal events from the SPI device driver e.g.
  * void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
@@ -29,9 +53,16 @@
 #include "dbc_assert.h" /* Design By Contract (DBC) assertions */
 #include <string.h>
 #include "bsp.h"
+#include "cmsis_gcc.h" /*__CLZ*/
 
 DBC_MODULE_NAME("spi_mgr")
 
+#define SPIMANAGER_NO_JOB (0xFFu) /*end of a FIFO, of the backoff list or of the free list*/
+
+#if (SPIMANAGER_QUEUE_SIZE > 254) || (SPIMANAGER_NUM_PRIOS > 32u)
+#error "SPIMANAGER_QUEUE_SIZE must fit the uint8_t slot links and SPIMANAGER_NUM_PRIOS the JobsReady bitmap"
+#endif
+
 /******************************private data*******************************************/
 
 /*immutable txrx complete event signal*/
@@ -50,19 +81,51 @@ static void SPIManager_task_Handler(SPIManager_Task_t *const me,
 static void SPIManager_init_Handler(SPIManager_Task_t *const me,
 		SPIManager_Evnt_t const *const ie);
 
-void SPIManager_start_txrx(SPIManager_Task_t *const me, SPIManager_Job_t *pJob);
+uint8_t SPIManager_start_txrx(SPIManager_Task_t *const me, uint8_t slot);
+
+static uint8_t SPIManager_start_job(SPIManager_Task_t *const me,
+		SPIManager_Job_t const *const pJob);
+
+static uint8_t SPIManager_start_seg(SPIManager_Task_t *const me);
+
+static uint8_t SPIManager_reg_start_seg(SPIManager_Task_t *const me, uint8_t const *txData,
+		uint8_t *rxData, uint16_t lenData);
 
 void SPIManager_txrx_complete_Handler(SPIManager_Task_t *const me);
 
+static uint8_t SPIManager_seg_done(SPIManager_Task_t *const me);
+
+static void SPIManager_seg_done_polled(SPIManager_Task_t *const me);
+
 void SPIManager_txrx_Req_Handler(SPIManager_Task_t *const me,
 		const SPIManager_Evnt_t *const e);
 
 void SPIManager_Timeout_Handler(SPIManager_Task_t *const me);
 
-HAL_StatusTypeDef SPIManager_enqueue_Job(SPIManager_Task_t *const me,
-		SPIManager_Job_t *pJob);
+void SPIManager_Backoff_Handler(SPIManager_Task_t *const me);
+
+static uint8_t SPIManager_start_next(SPIManager_Task_t *const me);
+
+static uint8_t SPIManager_xfer_idle(SPIManager_Task_t *const me);
+
+static void SPIManager_arm_timeout(SPIManager_Task_t *const me, uint16_t timeout_ms);
+
+static void SPIManager_disarm_timeout(SPIManager_Task_t *const me);
+
+static uint8_t SPIManager_take_slot(SPIManager_Task_t *const me, SPIManager_Evnt_t *const pReq);
 
-SPIManager_Job_t* SPIManager_dequeue_Job(SPIManager_Task_t *const me);
+static void SPIManager_release_slot(SPIManager_Task_t *const me, uint8_t slot);
+
+void SPIManager_enqueue_Job(SPIManager_Task_t *const me, uint8_t slot);
+
+uint8_t SPIManager_dequeue_Job(SPIManager_Task_t *const me);
+
+static void SPIManager_park_Job(SPIManager_Task_t *const me, uint8_t slot);
+
+static void SPIManager_respond(SPIManager_Task_t *const me, SPIManager_JobStatus_t status);
+
+static void SPIManager_set_bus(SPIManager_Task_t *const me,
+		SPIManager_SlaveCfg_t const *pCfg);
 
 /**********************Public Function Declarations*********************************/
 
@@ -76,14 +139,115 @@ void SPIManager_ctor(SPIManager_Task_t *const me, SPI_HandleTypeDef *pspiDevice)
 	SST_Task_ctor(&(me->super), (SST_Handler) &SPIManager_init_Handler,
 			(SST_Handler) &SPIManager_task_Handler);
 	SST_TimeEvt_ctor(&(me->JobTimeoutTimer), SPI_TIMEOUT_SIG, &(me->super));
+	SST_TimeEvt_ctor(&(me->BackoffTimer), SPI_BACKOFF_SIG, &(me->super));
 
 	/*initialise simple fields*/
 	me->pCurrentJob = NULL;
-	me->JobsHead = 0;
-	me->JobsTail = 0;
+	me->pCurrentReq = NULL;
+	me->currentSeg = 0u;
 	me->MgrState = SPI_MGR_READY;
-	memset(me->pMgrJobs, 0u, SPIMANAGER_QUEUE_SIZE * sizeof(SPIManager_Job_t*));
+	me->XferMode = SPI_MGR_XFER_IT;
+	me->pRegs = NULL;
+	me->pollMaxLen = 0u;
+	me->regTx = NULL;
+	me->regRx = NULL;
+	me->regLen = 0u;
+	me->regIdx = 0u;
+	me->nPolledSegs = 0u;
+	me->nIrqSegs = 0u;
+	me->currentSlot = SPIMANAGER_NO_JOB;
+	memset(me->pMgrJobs, 0u, SPIMANAGER_NUM_SLOTS * sizeof(SPIManager_Evnt_t*));
+	memset(me->JobsDue, 0u, SPIMANAGER_NUM_SLOTS * sizeof(uint32_t));
+	for (uint32_t i = 0u; i < SPIMANAGER_NUM_SLOTS; i++) {
+		me->JobsNext[i] = (uint8_t) (i + 1u); /*every slot on the free list*/
+	}
+	me->JobsNext[SPIMANAGER_NUM_SLOTS - 1u] = SPIMANAGER_NO_JOB;
+	me->JobsFree = 0u;
+	for (uint32_t p = 0u; p < SPIMANAGER_NUM_PRIOS; p++) {
+		me->JobsHead[p] = SPIMANAGER_NO_JOB;
+		me->JobsTail[p] = SPIMANAGER_NO_JOB;
+		me->JobsAge[p] = 0u;
+	}
+	me->JobsReady = 0u;
+	me->nAged = 0u;
+	me->nextSeq = 0u;
+	me->BackoffHead = SPIMANAGER_NO_JOB;
+	me->nTimeouts = 0u;
+	me->nRetries = 0u;
+	me->nAbandoned = 0u;
+	me->nLateCplt = 0u;
+	me->cpltSuspect = 0u;
+	me->timeoutArmed = 0u;
+	me->staleTimeouts = 0u;
+	me->jobStart = 0u;
 	me->pSPIPeriph = pspiDevice;
+	/*the SPI is initialised before the manager, its settings serve jobs without a slave config*/
+	me->defaultCfg.BaudRatePrescaler = pspiDevice->Init.BaudRatePrescaler;
+	me->defaultCfg.CLKPolarity = pspiDevice->Init.CLKPolarity;
+	me->defaultCfg.CLKPhase = pspiDevice->Init.CLKPhase;
+	me->defaultCfg.DataSize = pspiDevice->Init.DataSize;
+	me->busCfg = me->defaultCfg;
+	me->nReconfig = 0u;
+}
+
+/**
+ * @brief SPIManager_set_XferMode - Selects interrupt (default) or DMA driven transfers, call before
+ * the manager task starts. Completions come the same way (HAL_SPI_TxRxCpltCallback) in both modes,
+ * from the SPI interrupt or from the DMA stream interrupt.
+ * @param me - SPIManager instance variable.
+ * @param mode - SPI_MGR_XFER_IT or SPI_MGR_XFER_DMA (needs the DMA handles linked to the SPI handle)
+ */
+void SPIManager_set_XferMode(SPIManager_Task_t *const me, SPIManager_XferMode_t mode) {
+	DBC_ASSERT(6, (me != NULL) && (me->MgrState == SPI_MGR_READY)
+			&& ((mode == SPI_MGR_XFER_IT)
+					|| ((mode == SPI_MGR_XFER_DMA) && (me->pSPIPeriph->hdmatx != NULL)
+							&& (me->pSPIPeriph->hdmarx != NULL))
+					|| ((mode == SPI_MGR_XFER_REG) && (me->pRegs != NULL))));
+	me->XferMode = mode;
+}
+
+/**
+ * @brief SPIManager_set_RegEngine - Selects the register engine, call before the manager task
+ * starts. The SPI must be initialised (HAL_SPI_Init) as a full duplex 8 bit master, the engine only
+ * enables it and moves the data. Segments of up to pollMaxLen bytes are busy-polled in the manager
+ * task, longer ones need SPIManager_reg_IRQHandler called from the SPI IRQ handler.
+ * @param me - SPIManager instance variable.
+ * @param pRegs - SPI registers to drive, normally pSPIPeriph->Instance (or a model of them)
+ * @param pollMaxLen - longest busy-polled segment, 0 to run every segment on the interrupt
+ */
+void SPIManager_set_RegEngine(SPIManager_Task_t *const me, SPI_TypeDef *pRegs,
+		uint16_t pollMaxLen) {
+	DBC_ASSERT(7, (me != NULL) && (pRegs != NULL));
+	me->pRegs = pRegs;
+	me->pollMaxLen = pollMaxLen;
+	SPIManager_set_XferMode(me, SPI_MGR_XFER_REG);
+}
+
+/**
+ * @brief SPIManager_reg_IRQHandler - RXNE interrupt of a register engine segment, reads the byte
+ * received and writes the next one, posts SPI_TXRXCOMPLETE_SIG to the manager after the last one.
+ * Call from the SPI IRQ handler while the manager is in the register engine mode.
+ * @param me - SPIManager instance variable.
+ */
+void SPIManager_reg_IRQHandler(SPIManager_Task_t *const me) {
+	SPI_TypeDef *regs = me->pRegs;
+
+	if (((regs->CR2 & SPI_CR2_RXNEIE) == 0u) || ((SPIMANAGER_SPI_SR(regs) & SPI_SR_RXNE) == 0u)) {
+		return;
+	}
+	uint16_t idx = me->regIdx;
+	uint8_t data = SPIMANAGER_SPI_DR_READ(regs);
+	if (me->regRx != NULL) {
+		me->regRx[idx] = data;
+	}
+	idx++;
+	me->regIdx = idx;
+	if (idx < me->regLen) {
+		SPIMANAGER_SPI_DR_WRITE(regs, (me->regTx != NULL) ? me->regTx[idx] : 0u);
+	} else {
+		regs->CR2 &= ~SPI_CR2_RXNEIE;
+		SST_Task_post(&(me->super), pTxRxCompleteEventSignal);
+	}
 }
 
 /**
@@ -93,13 +257,39 @@ void SPIManager_ctor(SPIManager_Task_t *const me, SPI_HandleTypeDef *pspiDevice)
  */
 void SPIManager_post_txrx_Request(SST_Task *const AO, SPIManager_Evnt_t *pEvent) {
 
-/*ensure the contents of the request are valid and of SPI_TXRXREQ_SIG type*/
+/*ensure the contents of the request are valid and of SPI_TXRXREQ_SIG type, or a request that came
+ *back as a detailed response*/
 	DBC_ASSERT(0,
-			(AO != NULL) && (pEvent != NULL) && (pEvent->pJob != NULL) && (pEvent->super.sig == SPI_TXRXREQ_SIG));
+			(AO != NULL) && (pEvent != NULL) && (pEvent->pJob != NULL)
+					&& ((pEvent->super.sig == SPI_TXRXREQ_SIG)
+							|| (pEvent->super.sig == SPI_TXRXCOMPLETE_SIG)
+							|| (pEvent->super.sig == SPI_TIMEOUT_SIG)));
 
+	pEvent->super.sig = SPI_TXRXREQ_SIG; /*a response is a request again*/
 	SST_Task_post(AO, SST_EVT_DOWNCAST(SST_Evt, pEvent));
 }
 
+/**
+ * @brief SPIManager_new_txrx_Request - Allocates a dynamic SPI_TXRXREQ_SIG request event holding a copy of the job.
+ * The event is recycled by the manager once the job has completed or timed out, so the requester
+ * may reuse its job straight after posting. The tx and rx buffers must still stay valid until the response.
+ * @param pJob - job to copy into the request
+ * @return - request event to pass to SPIManager_post_txrx_Request
+ */
+SPIManager_Evnt_t* SPIManager_new_txrx_Request(SPIManager_Job_t const *const pJob) {
+
+	DBC_ASSERT(5, (pJob != NULL) && ((pJob->pAOrequester != NULL) || (pJob->pfComplete != NULL)));
+
+	SPIManager_JobEvnt_t *pEvent = SST_EVT_NEW(SPIManager_JobEvnt_t, SPI_TXRXREQ_SIG);
+	pEvent->Job = *pJob;
+	pEvent->super.pJob = &(pEvent->Job);
+	pEvent->super.seq = 0u;
+	pEvent->super.busTime = 0u;
+	pEvent->super.status = SPI_JOB_OK;
+	pEvent->super.attempt = 0u;
+	return &(pEvent->super);
+}
+
 /**********************Private Function Declarations*********************************/
 
 /*The init event handler does nothing currently as everything is initialised in the constructor*/
@@ -131,6 +321,10 @@ void SPIManager_task_Handler(SPIManager_Task_t *const me,
 		SPIManager_Timeout_Handler(me);
 		break;
 	}
+	case SPI_BACKOFF_SIG: {
+		SPIManager_Backoff_Handler(me);
+		break;
+	}
 	default: {
 		DBC_ERROR(200);
 	}
@@ -150,139 +344,572 @@ void SPIManager_txrx_Req_Handler(SPIManager_Task_t *const me,
 
 	DBC_ASSERT(20, (me != NULL) && (e != NULL) && (e->pJob != NULL));
 
+	/*the manager owns the request from here until it answers, it keeps its sequence number and
+	 *retry count in it and may send it back as the response. A dynamic request (and the job it
+	 *carries) is kept alive by a reference until then*/
+	SPIManager_Evnt_t *pReq = (SPIManager_Evnt_t*) e;
+	SST_Evt_ref(&(pReq->super));
+	pReq->seq = me->nextSeq;
+	pReq->attempt = 0u;
+	me->nextSeq++;
+
+	uint8_t slot = SPIManager_take_slot(me, pReq);
+	DBC_ASSERT(21, slot != SPIMANAGER_NO_JOB); /*assert there was space in the queue*/
+
 	if (me->MgrState == SPI_MGR_BUSY) {
 		/*save job for when previous job has completed*/
+		SPIManager_enqueue_Job(me, slot);
 
-		HAL_StatusTypeDef enqueueResult = SPIManager_enqueue_Job(me, e->pJob);
-		DBC_ASSERT(21, enqueueResult != HAL_ERROR); /*assert there was space in the queue*/
-
-	} else {
-		SPIManager_start_txrx(me, e->pJob);
+	} else if (SPIManager_start_txrx(me, slot) != 0u) {
+		SPIManager_seg_done_polled(me); /*busy-polled to completion already*/
 	}
 }
 
 /**
- * @brief SPIManager_start_txrx - Helper function which wraps the HAL call to the SPI txrx function. 
- * Additionally it unsets the jobs desired chip select pin
- * And arms a timeout counter. 
+ * @brief SPIManager_start_txrx - Starts the job (chain) carried by a request.
  * @param me - me pointer
- * @param e - pointer to event that triggered this call. 
+ * @param slot - slot of the request event carrying the job to start.
+ * @return - 1 if its first segment was busy-polled to completion, 0 if it is in progress
+ */
+uint8_t SPIManager_start_txrx(SPIManager_Task_t *const me, uint8_t slot) {
+	SPIManager_Evnt_t *pReq = me->pMgrJobs[slot];
+
+	DBC_ASSERT(1, (me != NULL)
+			&& ((pReq->pJob->pAOrequester != NULL) || (pReq->pJob->pfComplete != NULL)));
+
+	me->currentSlot = slot;
+	me->pCurrentReq = pReq;
+	me->MgrState = SPI_MGR_BUSY;
+	me->jobStart = SST_PORT_STAT_TIME();
+	return SPIManager_start_job(me, pReq->pJob);
+}
+
+/**
+ * @brief SPIManager_start_job - Sets the jobs chip select pin low, starts its first segment
+ * and arms the timeout counter for the job.
+ * @param me - me pointer
+ * @param pJob - job to start
+ * @return - 1 if the segment was busy-polled to completion, 0 if it is in progress
  */
-void SPIManager_start_txrx(SPIManager_Task_t *const me, SPIManager_Job_t *pJob) {
+static uint8_t SPIManager_start_job(SPIManager_Task_t *const me,
+		SPIManager_Job_t const *const pJob) {
 
-	DBC_ASSERT(1, (me != NULL) && (pJob->pAOrequester != NULL));
+	DBC_ASSERT(3, (pJob->numSegs == 0u) || (pJob->pSegs != NULL));
 
+	SPIManager_set_bus(me, pJob->pSlaveCfg); /*while every chip select is high*/
 	HAL_GPIO_WritePin(pJob->pcsGPIOPort, pJob->csGPIOPin, GPIO_PIN_RESET); /*set the chip select pin low*/
 
-	HAL_StatusTypeDef result = HAL_SPI_TransmitReceive_IT(me->pSPIPeriph,
-			pJob->txData, pJob->rxData, pJob->lenData);
 	me->pCurrentJob = pJob;
-	me->MgrState = SPI_MGR_BUSY;
-	SST_TimeEvt_arm(&(me->JobTimeoutTimer), pJob->timeoutCnt_ms, 0u);
+	me->currentSeg = 0u;
+	SPIManager_arm_timeout(me, pJob->timeoutCnt_ms);
+	return SPIManager_start_seg(me);
+}
+
+/**
+ * @brief SPIManager_start_seg - Helper function which wraps the HAL call that clocks the current
+ * segment of the current job, transmit and/or receive depending on its buffers.
+ * @param me - me pointer
+ * @return - 1 if the register engine busy-polled the segment to completion, 0 if it is in progress
+ */
+static uint8_t SPIManager_start_seg(SPIManager_Task_t *const me) {
+	SPIManager_Job_t const *pJob = me->pCurrentJob;
+	uint8_t *txData = pJob->txData;
+	uint8_t *rxData = pJob->rxData;
+	uint16_t lenData = pJob->lenData;
+	HAL_StatusTypeDef result;
+
+	if (pJob->numSegs != 0u) {
+		txData = pJob->pSegs[me->currentSeg].txData;
+		rxData = pJob->pSegs[me->currentSeg].rxData;
+		lenData = pJob->pSegs[me->currentSeg].lenData;
+	}
+
+	if (me->XferMode == SPI_MGR_XFER_REG) {
+		return SPIManager_reg_start_seg(me, txData, rxData, lenData);
+	} else if (me->XferMode == SPI_MGR_XFER_DMA) {
+		if (txData == NULL) {
+			result = HAL_SPI_Receive_DMA(me->pSPIPeriph, rxData, lenData);
+		} else if (rxData == NULL) {
+			result = HAL_SPI_Transmit_DMA(me->pSPIPeriph, txData, lenData);
+		} else {
+			result = HAL_SPI_TransmitReceive_DMA(me->pSPIPeriph, txData, rxData, lenData);
+		}
+	} else {
+		if (txData == NULL) {
+			result = HAL_SPI_Receive_IT(me->pSPIPeriph, rxData, lenData);
+		} else if (rxData == NULL) {
+			result = HAL_SPI_Transmit_IT(me->pSPIPeriph, txData, lenData);
+		} else {
+			result = HAL_SPI_TransmitReceive_IT(me->pSPIPeriph, txData, rxData, lenData);
+		}
+	}
 
 	DBC_ASSERT(2, result != HAL_ERROR);
+	return 0u;
+}
+
+/**
+ * @brief SPIManager_set_bus - Loads the bus settings of the slave of the next job into the SPI if
+ * they differ from the ones loaded. The SPI is disabled for the change, the next transfer enables
+ * it again (the HAL and the register engine both do).
+ * @param me - me pointer
+ * @param pCfg - settings of the slave, NULL for the ones the SPI was initialised with
+ */
+static void SPIManager_set_bus(SPIManager_Task_t *const me,
+		SPIManager_SlaveCfg_t const *pCfg) {
+	if (pCfg == NULL) {
+		pCfg = &(me->defaultCfg);
+	}
+	if ((pCfg->BaudRatePrescaler == me->busCfg.BaudRatePrescaler)
+			&& (pCfg->CLKPolarity == me->busCfg.CLKPolarity)
+			&& (pCfg->CLKPhase == me->busCfg.CLKPhase)
+			&& (pCfg->DataSize == me->busCfg.DataSize)) {
+		return;
+	}
+
+	DBC_ASSERT(9, (me->XferMode != SPI_MGR_XFER_REG) || (pCfg->DataSize == SPI_DATASIZE_8BIT));
+
+	SPI_TypeDef *regs = (me->XferMode == SPI_MGR_XFER_REG) ? me->pRegs : me->pSPIPeriph->Instance;
+	regs->CR1 &= ~SPI_CR1_SPE; /*BR, CPOL, CPHA and DFF may only change while disabled*/
+	regs->CR1 = (regs->CR1 & ~(SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_DFF))
+			| pCfg->BaudRatePrescaler | pCfg->CLKPolarity | pCfg->CLKPhase | pCfg->DataSize;
+
+	/*the HAL transfer calls pick 8 or 16 bit frames from the init settings*/
+	me->pSPIPeriph->Init.BaudRatePrescaler = pCfg->BaudRatePrescaler;
+	me->pSPIPeriph->Init.CLKPolarity = pCfg->CLKPolarity;
+	me->pSPIPeriph->Init.CLKPhase = pCfg->CLKPhase;
+	me->pSPIPeriph->Init.DataSize = pCfg->DataSize;
+
+	me->busCfg = *pCfg;
+	me->nReconfig++;
+}
+
+/**
+ * @brief SPIManager_reg_start_seg - Register engine transfer of a segment. Up to pollMaxLen bytes
+ * are clocked here a byte at a time (write DR on TXE, read DR on RXNE), otherwise the first byte is
+ * written with the RXNE interrupt enabled and SPIManager_reg_IRQHandler clocks the rest.
+ * @param me - me pointer
+ * @param txData - bytes to send, NULL sends zeros
+ * @param rxData - buffer for the bytes received, NULL drops them
+ * @param lenData - bytes in the segment
+ * @return - 1 if the segment was busy-polled to completion, 0 if it is in progress (or the bus
+ * stuck, then the job times out)
+ */
+static uint8_t SPIManager_reg_start_seg(SPIManager_Task_t *const me, uint8_t const *txData,
+		uint8_t *rxData, uint16_t lenData) {
+	SPI_TypeDef *regs = me->pRegs;
+
+	DBC_ASSERT(8, lenData != 0u);
+
+	if ((regs->CR1 & SPI_CR1_SPE) == 0u) {
+		regs->CR1 |= SPI_CR1_SPE;
+	}
+
+	if (lenData > me->pollMaxLen) {
+		me->regTx = txData;
+		me->regRx = rxData;
+		me->regLen = lenData;
+		me->regIdx = 0u;
+		me->nIrqSegs++;
+		regs->CR2 |= SPI_CR2_RXNEIE;
+		SPIMANAGER_SPI_DR_WRITE(regs, (txData != NULL) ? txData[0] : 0u);
+		return 0u;
+	}
+
+	me->nPolledSegs++;
+	for (uint32_t i = 0u; i < lenData; i++) {
+		uint32_t spin = SPIMANAGER_POLL_SPIN;
+		while ((SPIMANAGER_SPI_SR(regs) & SPI_SR_TXE) == 0u) {
+			if (--spin == 0u) {
+				return 0u;
+			}
+		}
+		SPIMANAGER_SPI_DR_WRITE(regs, (txData != NULL) ? txData[i] : 0u);
+		while ((SPIMANAGER_SPI_SR(regs) & SPI_SR_RXNE) == 0u) {
+			if (--spin == 0u) {
+				return 0u;
+			}
+		}
+		uint8_t data = SPIMANAGER_SPI_DR_READ(regs);
+		if (rxData != NULL) {
+			rxData[i] = data;
+		}
+	}
+	/*RXNE of the last byte comes with its last clock edge, BSY drops straight after*/
+	uint32_t spin = SPIMANAGER_POLL_SPIN;
+	while ((SPIMANAGER_SPI_SR(regs) & SPI_SR_BSY) != 0u) {
+		if (--spin == 0u) {
+			return 0u;
+		}
+	}
+	return 1u;
 }
 
 /**
  * @brief SPIManager_txrx_complete_Handler - event handler called when a SPI_TXRXCOMPLETE_SIG
- * And arms a timeout counter. 
+ * Starts the next segment of the job or the next job of the chain, otherwise answers the requester
+ * and starts the next queued job.
  * @param me - me pointer
  */
 void SPIManager_txrx_complete_Handler(SPIManager_Task_t *const me) {
 
-	/*its expected that the spi manager is in the busy state if it gets a SPI_TXRXCOMPLETE_SIG*/
-	DBC_ASSERT(10, (me != NULL) && (me->MgrState== SPI_MGR_BUSY));
+	DBC_ASSERT(10, me != NULL);
+
+	/*a completion already on its way when its job timed out reports an aborted transfer, the job
+	 *on the bus now (if any) hasn't finished. The queue is FIFO so only the first completion after
+	 *the abort can be that one*/
+	uint8_t suspect = me->cpltSuspect;
+	me->cpltSuspect = 0u;
+	if ((me->MgrState != SPI_MGR_BUSY)
+			|| ((suspect != 0u) && (SPIManager_xfer_idle(me) == 0u))) {
+		me->nLateCplt++;
+		return;
+	}
+
+	SPIManager_seg_done_polled(me);
+}
 
-	HAL_GPIO_WritePin(me->pCurrentJob->pcsGPIOPort, me->pCurrentJob->csGPIOPin,
+/**
+ * @brief SPIManager_seg_done_polled - The segment on the bus has finished, starts what comes next.
+ * Segments the register engine busy-polled finish straight away, carries on until one is left
+ * running on an interrupt or the manager is idle. Paths that started a busy-polled segment call it
+ * directly, the complete handler checks for a late completion (cpltSuspect) which they must leave
+ * to the SPI_TXRXCOMPLETE_SIG it is for.
+ * @param me - me pointer
+ */
+static void SPIManager_seg_done_polled(SPIManager_Task_t *const me) {
+	while (SPIManager_seg_done(me) != 0u) {
+	}
+}
+
+/**
+ * @brief SPIManager_seg_done - The segment on the bus has finished, starts what comes next.
+ * @param me - me pointer
+ * @return - 1 if what was started was busy-polled to completion too
+ */
+static uint8_t SPIManager_seg_done(SPIManager_Task_t *const me) {
+	SPIManager_Job_t const *pJob = me->pCurrentJob;
+
+	/*next segment of the same job, the chip select stays low*/
+	if ((me->currentSeg + 1u) < pJob->numSegs) {
+		me->currentSeg++;
+		return SPIManager_start_seg(me);
+	}
+
+	HAL_GPIO_WritePin(pJob->pcsGPIOPort, pJob->csGPIOPin,
 			GPIO_PIN_SET); /*set the chip select pin high*/
 
-	/*Post tx complete signal back to the requesting thread*/
-	SST_Task_post((SST_Task* const ) me->pCurrentJob->pAOrequester,
-			pTxRxCompleteEventSignal);
+	/*next job of the chain, straight away and with its own timeout*/
+	if (pJob->pNext != NULL) {
+		return SPIManager_start_job(me, pJob->pNext);
+	}
+
+	SPIManager_respond(me, SPI_JOB_OK);
+
+	SPIManager_disarm_timeout(me); /*finished so disarm the timeout timer*/
 
-	/*disarm the timout timer*/
-	SST_TimeEvt_disarm(&me->JobTimeoutTimer); /*finished so disarm the timeout timer*/
+	SST_Evt_gc(&(me->pCurrentReq->super)); /*release the finished request*/
+	SPIManager_release_slot(me, me->currentSlot);
 
+	return SPIManager_start_next(me);
+}
+
+/**
+ * @brief SPIManager_start_next - The current request is done with the bus, starts the next queued
+ * one or goes back to the ready state.
+ * @param me - me pointer
+ * @return - 1 if the job started was busy-polled to completion
+ */
+static uint8_t SPIManager_start_next(SPIManager_Task_t *const me) {
 	/*check for new job to do*/
-	SPIManager_Job_t *newJob = SPIManager_dequeue_Job(me);
-	if (newJob == NULL) {
+	uint8_t slot = SPIManager_dequeue_Job(me);
+	if (slot == SPIMANAGER_NO_JOB) {
 		me->MgrState = SPI_MGR_READY; /*goto ready state ready to receive more jobs*/
 		me->pCurrentJob = NULL;
-	} else {
-		SPIManager_start_txrx(me, newJob);
+		me->pCurrentReq = NULL;
+		me->currentSlot = SPIMANAGER_NO_JOB;
+		return 0u;
+	}
+	return SPIManager_start_txrx(me, slot);
+}
+
+/**
+ * @brief SPIManager_xfer_idle - Checks the transfer of the current segment has really finished,
+ * the HAL is back to ready (it is before the complete callback) or the register engine has clocked
+ * every byte.
+ * @param me - me pointer
+ * @return - 1 if no transfer is in progress
+ */
+static uint8_t SPIManager_xfer_idle(SPIManager_Task_t *const me) {
+	if (me->XferMode == SPI_MGR_XFER_REG) {
+		return (me->regIdx >= me->regLen) ? 1u : 0u;
+	}
+	return (HAL_SPI_GetState(me->pSPIPeriph) == HAL_SPI_STATE_READY) ? 1u : 0u;
+}
+
+/**
+ * @brief SPIManager_arm_timeout - Arms the timeout of the job starting on the bus, in place of the
+ * one of the previous job of a chain.
+ * @param me - me pointer
+ * @param timeout_ms - timeout of the job, 0 for none
+ */
+static void SPIManager_arm_timeout(SPIManager_Task_t *const me, uint16_t timeout_ms) {
+	SPIManager_disarm_timeout(me);
+	SST_TimeEvt_arm(&(me->JobTimeoutTimer), timeout_ms, 0u);
+	me->timeoutArmed = (timeout_ms != 0u) ? 1u : 0u;
+}
+
+/**
+ * @brief SPIManager_disarm_timeout - Disarms the timeout of the job on the bus. A timer that was
+ * armed but is disarmed already has expired and its SPI_TIMEOUT_SIG is queued behind the event
+ * being handled, that one is counted so the timeout handler drops it instead of aborting whatever
+ * job is on the bus by then.
+ * @param me - me pointer
+ */
+static void SPIManager_disarm_timeout(SPIManager_Task_t *const me) {
+	if ((SST_TimeEvt_disarm(&(me->JobTimeoutTimer)) == false) && (me->timeoutArmed != 0u)) {
+		me->staleTimeouts++;
 	}
+	me->timeoutArmed = 0u;
 }
 
 /**
  * @brief SPIManager_Timeout_Handler - event handler called when the JobTimeoutTimer posts a Timer event.
- * This occurs when a job takes longer than the jobs timeoutCnt_ms to complete. It aboerts the current job 
- * and moves the device back to the ready state. 
- * And arms a timeout counter. 
+ * This occurs when a job takes longer than the jobs timeoutCnt_ms to complete. It aborts the current job,
+ * raises its chip select and either schedules a retry (straight away, or parked until its backoff
+ * has passed) or, after the last retry, answers the requester with SPI_TIMEOUT_SIG. The next queued
+ * job starts in both cases.
  * @param me - me device pointer
  */
 void SPIManager_Timeout_Handler(SPIManager_Task_t *const me) {
 
-	/*it's expected that the spi manager is in the busy state if it gets a SPI_TIMEOUT_SIG*/
-	DBC_ASSERT(30,
-			(me != NULL) && (me->pCurrentJob != NULL) && (me->pCurrentJob->pAOrequester != NULL) && (me->MgrState == SPI_MGR_BUSY));
+	DBC_ASSERT(30, me != NULL);
 
-	HAL_SPI_Abort(me->pSPIPeriph);
+	if (me->staleTimeouts != 0u) {
+		me->staleTimeouts--; /*posted just before its job completed and disarmed the timer*/
+		return;
+	}
+	DBC_ASSERT(31, (me->MgrState == SPI_MGR_BUSY) && (me->pCurrentJob != NULL)
+			&& (me->pCurrentReq != NULL));
+	me->timeoutArmed = 0u; /*expired*/
+
+	if (me->XferMode == SPI_MGR_XFER_REG) {
+		me->pRegs->CR2 &= ~SPI_CR2_RXNEIE;
+		me->regLen = 0u;
+		(void) SPIMANAGER_SPI_DR_READ(me->pRegs); /*drop a byte left over, clears RXNE*/
+	} else {
+		HAL_SPI_Abort(me->pSPIPeriph);
+	}
 
-	SST_Task_post((SST_Task* const ) me->pCurrentJob->pAOrequester,
-			ptxTimeoutEventSignal); /*Post tx timeout signal back to the requesting thread*/
+	HAL_GPIO_WritePin(me->pCurrentJob->pcsGPIOPort, me->pCurrentJob->csGPIOPin,
+			GPIO_PIN_SET); /*set the chip select pin high*/
+	me->nTimeouts++;
+	me->cpltSuspect = 1u;
+
+	SPIManager_Evnt_t *pReq = me->pCurrentReq;
+	SPIManager_Job_t const *pJob = pReq->pJob;
+
+	if (pReq->attempt < pJob->retries) {
+		pReq->attempt++;
+		me->nRetries++;
+		if (pJob->backoff_ms == 0u) {
+			/*again straight away, the whole chain from its first job*/
+			if (SPIManager_start_txrx(me, me->currentSlot) != 0u) {
+				SPIManager_seg_done_polled(me); /*busy-polled to completion already*/
+			}
+			return;
+		}
+		SPIManager_park_Job(me, me->currentSlot); /*keeps its slot and the manager's reference*/
+	} else {
+		me->nAbandoned++;
+		SPIManager_respond(me, SPI_JOB_TIMEOUT);
+		SST_Evt_gc(&(me->pCurrentReq->super)); /*release the aborted request*/
+		SPIManager_release_slot(me, me->currentSlot);
+	}
 
-	me->MgrState = SPI_MGR_READY; /*free the manager for other tasks*/
+	if (SPIManager_start_next(me) != 0u) {
+		SPIManager_seg_done_polled(me); /*busy-polled to completion already*/
+	}
 }
 
 /**
- * @brief SPIManager_enqueue_Job - Enqueues the job for later in the managers internal rolling FIFO buffer.
- * @param me - me device pointer 
- * @param pJob - pointer to the job to store in the queue.
- * @return - returns HAL_ERROR if the buffer is full.
+ * @brief SPIManager_Backoff_Handler - event handler for SPI_BACKOFF_SIG, the parked requests that
+ * have waited out their backoff start if the bus is free, otherwise they queue for it behind the
+ * jobs of their priority. The timer is armed again for the next one due.
+ * @param me - me device pointer
  */
-HAL_StatusTypeDef SPIManager_enqueue_Job(SPIManager_Task_t *const me,
-		SPIManager_Job_t *pJob) {
-	uint32_t tmpHead = me->JobsHead;
+void SPIManager_Backoff_Handler(SPIManager_Task_t *const me) {
+	uint32_t now = HAL_GetTick();
+
+	DBC_ASSERT(33, me != NULL);
+
+	/*a SPI_BACKOFF_SIG posted before the timer was armed again for an earlier request finds the
+	 *requests due by now, possibly none*/
+	while ((me->BackoffHead != SPIMANAGER_NO_JOB)
+			&& ((int32_t) (me->JobsDue[me->BackoffHead] - now) <= 0)) {
+		uint8_t slot = me->BackoffHead;
+		me->BackoffHead = me->JobsNext[slot];
+		if (me->MgrState == SPI_MGR_BUSY) {
+			SPIManager_enqueue_Job(me, slot);
+		} else if (SPIManager_start_txrx(me, slot) != 0u) {
+			SPIManager_seg_done_polled(me); /*busy-polled to completion already*/
+		}
+	}
+	if (me->BackoffHead != SPIMANAGER_NO_JOB) {
+		SST_TimeEvt_arm(&(me->BackoffTimer), (SST_TCtr) (me->JobsDue[me->BackoffHead] - now), 0u);
+	}
+}
 
-	/*increment and wrap the next index*/
-	uint32_t tmpNext = tmpHead + 1u;
-	if (SPIMANAGER_QUEUE_SIZE == tmpNext) {
-		tmpNext = 0;
+/**
+ * @brief SPIManager_respond - Tells the requester of the current request how its job (chain) ended,
+ * through the jobs completion callback if it has one, otherwise by posting the
+ * SPI_TXRXCOMPLETE_SIG or SPI_TIMEOUT_SIG signal back to the requesting thread, or the request
+ * itself for a detailed response.
+ * @param me - me device pointer
+ * @param status - how the job ended
+ */
+static void SPIManager_respond(SPIManager_Task_t *const me, SPIManager_JobStatus_t status) {
+	SPIManager_Job_t const *pJob = me->pCurrentReq->pJob;
+
+	if (pJob->pfComplete != NULL) {
+		pJob->pfComplete(pJob, status);
+	} else if (pJob->detailedResp != 0u) {
+		/*the post takes its own reference, the request outlives the manager's gc*/
+		SPIManager_Evnt_t *pResp = me->pCurrentReq;
+		pResp->super.sig = (status == SPI_JOB_OK) ? SPI_TXRXCOMPLETE_SIG : SPI_TIMEOUT_SIG;
+		pResp->status = status;
+		pResp->busTime = SST_PORT_STAT_TIME() - me->jobStart;
+		SST_Task_post((SST_Task* const ) pJob->pAOrequester, &(pResp->super));
+	} else {
+		SST_Task_post((SST_Task* const ) pJob->pAOrequester,
+				(status == SPI_JOB_OK) ? pTxRxCompleteEventSignal : ptxTimeoutEventSignal);
 	}
+}
+
+/**
+ * @brief SPIManager_take_slot - Takes a free slot for an accepted request, the request keeps it
+ * while it waits for the bus, is on the bus or waits out a backoff, until it is answered.
+ * @param me - me device pointer
+ * @param pReq - pointer to the request (carrying the job) to store in the slot.
+ * @return - the slot, SPIMANAGER_NO_JOB if the buffer is full.
+ */
+static uint8_t SPIManager_take_slot(SPIManager_Task_t *const me, SPIManager_Evnt_t *const pReq) {
+	uint8_t slot = me->JobsFree;
 
-	/*loose one cell in the buffer here but simplifies buffer full/empty detection*/
-	if (tmpNext == me->JobsTail) {
-		return HAL_ERROR; /*buffer full*/
+	if (slot != SPIMANAGER_NO_JOB) {
+		me->JobsFree = me->JobsNext[slot];
+		me->pMgrJobs[slot] = pReq;
 	}
+	return slot;
+}
+
+/**
+ * @brief SPIManager_release_slot - Puts the slot of an answered request back on the free list.
+ * @param me - me device pointer
+ * @param slot - slot of the answered request
+ */
+static void SPIManager_release_slot(SPIManager_Task_t *const me, uint8_t slot) {
+	me->pMgrJobs[slot] = NULL;
+	me->JobsNext[slot] = me->JobsFree;
+	me->JobsFree = slot;
+}
+
+/**
+ * @brief SPIManager_enqueue_Job - Enqueues the job for later at the end of the FIFO of its priority.
+ * @param me - me device pointer 
+ * @param slot - slot of the request (carrying the job) to queue.
+ */
+void SPIManager_enqueue_Job(SPIManager_Task_t *const me, uint8_t slot) {
+	uint8_t prio = me->pMgrJobs[slot]->pJob->priority;
 
-	me->pMgrJobs[tmpHead] = pJob;
-	me->JobsHead = tmpNext;
-	return HAL_OK;
+	DBC_ASSERT(40, prio < SPIMANAGER_NUM_PRIOS);
+
+	me->JobsNext[slot] = SPIMANAGER_NO_JOB;
+	if (me->JobsHead[prio] == SPIMANAGER_NO_JOB) {
+		me->JobsHead[prio] = slot;
+		me->JobsAge[prio] = 0u; /*a new oldest job starts aging*/
+		me->JobsReady |= (1UL << prio);
+	} else {
+		me->JobsNext[me->JobsTail[prio]] = slot;
+	}
+	me->JobsTail[prio] = slot;
 }
 
 /**
- * @brief SPIManager_dequeue_Job - pop a job from the managers internal rolling FIFO buffer.
- * returns NULL if the queue is empty.
+ * @brief SPIManager_dequeue_Job - pop the next job to start, the oldest job of the highest waiting
+ * priority or of a lower priority that has aged past SPIMANAGER_AGING_LIMIT.
+ * returns SPIMANAGER_NO_JOB if the queue is empty.
  * @param me - me device pointer 
- * @param pJob - pointer to the job to store in the queue.
- * @return - returns a pointer to the job taken from the queue, returns NULL if the queue is empty.
+ * @return - returns the slot of the request taken from the queue (it keeps the slot), returns
+ * SPIMANAGER_NO_JOB if the queue is empty.
  **/
-SPIManager_Job_t* SPIManager_dequeue_Job(SPIManager_Task_t *const me) {
-	{
-		uint32_t tmpTail = me->JobsTail;
-		uint32_t tmpTailNext = (uint16_t) tmpTail + 1u;
-		/*check for empty queue*/
-		if (me->JobsHead == tmpTail) {
-			return NULL;
+uint8_t SPIManager_dequeue_Job(SPIManager_Task_t *const me) {
+	if (me->JobsReady == 0u) {
+		return SPIMANAGER_NO_JOB;
+	}
+	uint32_t prio = 31u - __CLZ(me->JobsReady);
+
+#if (SPIMANAGER_AGING_LIMIT != 0u)
+	/*every lower priority that waits ages by one, the highest one that has waited long enough
+	 *goes first*/
+	uint32_t aged = SPIMANAGER_NUM_PRIOS;
+	uint32_t lower = me->JobsReady & ((1UL << prio) - 1u);
+	while (lower != 0u) {
+		uint32_t p = 31u - __CLZ(lower);
+		lower &= ~(1UL << p);
+		if (me->JobsAge[p] >= SPIMANAGER_AGING_LIMIT) {
+			if (aged == SPIMANAGER_NUM_PRIOS) {
+				aged = p;
+			}
+		} else {
+			me->JobsAge[p]++;
 		}
+	}
+	if (aged != SPIMANAGER_NUM_PRIOS) {
+		me->JobsAge[prio]++; /*the priority passed over ages too*/
+		prio = aged;
+		me->nAged++;
+	}
+#endif
+
+	uint8_t slot = me->JobsHead[prio];
+	me->JobsHead[prio] = me->JobsNext[slot];
+	me->JobsAge[prio] = 0u;
+	if (me->JobsHead[prio] == SPIMANAGER_NO_JOB) {
+		me->JobsTail[prio] = SPIMANAGER_NO_JOB;
+		me->JobsReady &= ~(1UL << prio);
+	}
+	return slot;
+}
 
-		/*wrap next tail*/
-		if (SPIMANAGER_QUEUE_SIZE == tmpTailNext) {
-			tmpTailNext = 0;
-		}
+/**
+ * @brief SPIManager_park_Job - Parks a timed out request until its backoff has passed, in the
+ * backoff list sorted by due tick (after the requests due at the same tick). The backoff doubles
+ * from the jobs backoff_ms for every retry, up to SPIMANAGER_BACKOFF_MAX_MS.
+ * @param me - me device pointer
+ * @param slot - slot of the timed out request, attempt counts the retry it waits for
+ */
+static void SPIManager_park_Job(SPIManager_Task_t *const me, uint8_t slot) {
+	SPIManager_Evnt_t const *pReq = me->pMgrJobs[slot];
+	uint32_t backoff = pReq->pJob->backoff_ms;
 
-		me->JobsTail = tmpTailNext;
-		return me->pMgrJobs[tmpTail];
+	for (uint32_t i = 1u; (i < pReq->attempt) && (backoff < SPIMANAGER_BACKOFF_MAX_MS); i++) {
+		backoff *= 2u;
 	}
-}
+	if (backoff > SPIMANAGER_BACKOFF_MAX_MS) {
+		backoff = SPIMANAGER_BACKOFF_MAX_MS;
+	}
+	uint32_t due = HAL_GetTick() + backoff;
+	me->JobsDue[slot] = due;
+
+	uint8_t *pLink = &(me->BackoffHead);
+	while ((*pLink != SPIMANAGER_NO_JOB) && ((int32_t) (me->JobsDue[*pLink] - due) <= 0)) {
+		pLink = &(me->JobsNext[*pLink]);
+	}
+	me->JobsNext[slot] = *pLink;
+	*pLink = slot;
 
+	if (me->BackoffHead == slot) { /*due first, the timer waits for it now*/
+		SST_TimeEvt_arm(&(me->BackoffTimer), (SST_TCtr) backoff, 0u);
+	}
+}
@@ -28,6 +28,11 @@
 
 DBC_MODULE_NAME("sst")  /* for DBC assertions in this module */
 
+/*! cast away the const of an event to update its reference counter */
+#define SST_EVT_CONST_CAST(e_) ((SST_Evt *)(e_))
+
+static void SST_PubSub_register_(SST_Task * const me, SST_TaskPrio prio);
+
 /*..........................................................................*/
 int SST_Task_run(void) {
     SST_start();   /* port-specific start of multitasking */
@@ -46,6 +51,7 @@ void SST_Task_ctor(
 {
     me->init = init;
     me->dispatch = dispatch;
+    me->batch = 1U; /* one event per activation by default */
 }
 /*..........................................................................*/
 void SST_Task_start(
@@ -67,34 +73,329 @@ void SST_Task_start(
     me->head  = 0U;
     me->tail  = 0U;
     me->nUsed = 0U;
+    for (SST_QCtr i = 0U; i <= me->end; ++i) {
+        qBuf[i] = (SST_Evt const *)0; /* empty entry */
+    }
 
+#if (SST_TASK_STATS != 0)
+    SST_Task_resetStat(me);
+#endif
+    SST_PubSub_register_(me, prio);
     SST_Task_setPrio(me, prio);
 
     /* initialize this task with the initialization event */
     (*me->init)(me, ie); /* NOTE: virtual call */
-    /* TBD: implement event recycling */
+    if (ie != (SST_Evt const *)0) {
+        SST_Evt_gc(ie); /* recycle the initialization event, if dynamic */
+    }
 }
 /*..........................................................................*/
 void SST_Task_post(SST_Task * const me, SST_Evt const * const e) {
-    /*! @pre the queue must be sized adequately and cannot overflow */
-    DBC_REQUIRE(300, me->nUsed <= me->end);
+    /* NOTE:
+    * the queue is a multiple-producer, single-consumer ring without any
+    * critical section. A producer first reserves an entry in nUsed, then
+    * claims the head index and finally stores the event into the claimed
+    * entry. The consumer (SST_Task_activate) treats an empty entry as
+    * "reserved, but not stored yet" and waits for the pend that follows
+    * the store.
+    */
+    SST_QCtr nUsed;
+    do {
+        nUsed = SST_PORT_LOAD8(&me->nUsed);
+        /*! @pre the queue must be sized adequately and cannot overflow */
+        DBC_REQUIRE(300, nUsed <= me->end);
+    } while (!SST_PORT_CAS8(&me->nUsed, nUsed, (SST_QCtr)(nUsed + 1U)));
+
+    SST_Evt_ref(e); /* the queue holds a reference to a dynamic event */
+
+    SST_QCtr head;
+    SST_QCtr next;
+    do {
+        head = SST_PORT_LOAD8(&me->head);
+        next = (head == 0U) ? me->end /* wrap around */
+                            : (SST_QCtr)(head - 1U);
+    } while (!SST_PORT_CAS8(&me->head, head, next));
+
+    SST_PORT_TASK_CLAIM(); /* the entry is not visible to the consumer yet */
+    SST_PORT_EVT_STORE(&me->qBuf[head], e); /* insert event into the queue */
+    SST_PORT_TASK_PEND();
+}
+/*..........................................................................*/
+void SST_Task_setBatch(SST_Task * const me, SST_QCtr batch) {
+    /*! @pre at least one event must be dispatched per activation */
+    DBC_REQUIRE(400, batch > 0U);
+
+    me->batch = batch;
+}
+
+#if (SST_TASK_STATS != 0)
+/*..........................................................................*/
+SST_TaskStat const *SST_Task_getStat(SST_Task const * const me) {
+    return &me->stat;
+}
+/*..........................................................................*/
+void SST_Task_resetStat(SST_Task * const me) {
+    me->stat.nDispatch = 0U;
+    me->stat.runMin    = UINT32_MAX;
+    me->stat.runMax    = 0U;
+    me->stat.runTotal  = 0U;
+    me->stat.maxUsed   = 0U;
+}
+/*..........................................................................*/
+void SST_Task_statDispatch(SST_Task * const me,
+                           SST_QCtr nUsed, uint32_t runTime)
+{
+    /* NOTE: no critical section because the statistics are updated only
+    * from this task
+    */
+    ++me->stat.nDispatch;
+    me->stat.runTotal += runTime;
+    if (runTime < me->stat.runMin) {
+        me->stat.runMin = runTime;
+    }
+    if (runTime > me->stat.runMax) {
+        me->stat.runMax = runTime;
+    }
+    if (nUsed > me->stat.maxUsed) {
+        me->stat.maxUsed = nUsed;
+    }
+}
+#endif /* SST_TASK_STATS */
+
+/*--------------------------------------------------------------------------*/
+typedef struct {
+    void *pool;
+    SST_EvtPoolGet get;
+    SST_EvtPoolPut put;
+    uint16_t blockSize;
+    SST_EvtPoolStat stat;
+} SST_EvtPool;
+
+static SST_EvtPool evtPools[SST_MAX_EVT_POOLS];
+static uint_fast8_t evtPools_num;
 
+/*..........................................................................*/
+void SST_Evt_addPool(
+    void * const pool,
+    uint16_t blockSize,
+    SST_EvtPoolGet get,
+    SST_EvtPoolPut put)
+{
+    /*! @pre
+    * - there must be room for the pool
+    * - pools must be added in ascending order of block size
+    */
+    DBC_REQUIRE(600,
+        (evtPools_num < SST_MAX_EVT_POOLS)
+        && ((evtPools_num == 0U)
+            || (evtPools[evtPools_num - 1U].blockSize < blockSize))
+        && (pool != (void *)0) && (get != (SST_EvtPoolGet)0)
+        && (put != (SST_EvtPoolPut)0));
+
+    evtPools[evtPools_num].pool = pool;
+    evtPools[evtPools_num].get = get;
+    evtPools[evtPools_num].put = put;
+    evtPools[evtPools_num].blockSize = blockSize;
+    evtPools[evtPools_num].stat = (SST_EvtPoolStat){ 0U };
+    ++evtPools_num;
+}
+/*..........................................................................*/
+SST_Evt *SST_Evt_new(uint16_t evtSize, SST_Signal sig) {
+    /* find the first (smallest) pool that fits the requested event */
+    uint_fast8_t idx = 0U;
+    while ((idx < evtPools_num) && (evtPools[idx].blockSize < evtSize)) {
+        ++idx;
+    }
+    /*! @pre an event pool for the requested size must exist */
+    DBC_REQUIRE(700, idx < evtPools_num);
+
+    /* fall through to the larger pools while the fitting ones are empty */
     SST_PORT_CRIT_STAT
+    uint_fast8_t const fit = idx;
+    SST_Evt *e = (SST_Evt *)0;
+    for (; idx < evtPools_num; ++idx) {
+        e = (SST_Evt *)(*evtPools[idx].get)(evtPools[idx].pool, evtSize);
+        if (e != (SST_Evt *)0) {
+            break;
+        }
+        SST_PORT_CRIT_ENTRY();
+        ++evtPools[idx].stat.nEmpty;
+        SST_PORT_CRIT_EXIT();
+    }
+    /* the pools must not run out of events */
+    DBC_ASSERT(710, e != (SST_Evt *)0);
+
+    SST_EvtPoolStat * const stat = &evtPools[idx].stat;
     SST_PORT_CRIT_ENTRY();
-    me->qBuf[me->head] = e; /* insert event into the queue */
-    if (me->head == 0U) {   /* need to wrap the head? */
-        me->head = me->end; /* wrap around */
+    ++stat->nAlloc;
+    if (idx != fit) {
+        ++stat->nFallback;
     }
-    else {
-        --me->head;
+    if (++stat->nUsed > stat->maxUsed) {
+        stat->maxUsed = stat->nUsed;
     }
-    ++me->nUsed;
-    SST_PORT_TASK_PEND();
     SST_PORT_CRIT_EXIT();
+
+    e->sig = sig;
+    e->poolNum = (uint8_t)(idx + 1U);
+    e->refCtr = 0U;
+    return e;
+}
+/*..........................................................................*/
+void SST_Evt_ref(SST_Evt const * const e) {
+    if (e->poolNum != 0U) { /* is it a dynamic event? */
+        uint8_t volatile *refCtr = &SST_EVT_CONST_CAST(e)->refCtr;
+        uint8_t ctr;
+        do {
+            ctr = SST_PORT_LOAD8(refCtr);
+        } while (!SST_PORT_CAS8(refCtr, ctr, (uint8_t)(ctr + 1U)));
+    }
+}
+/*..........................................................................*/
+void SST_Evt_gc(SST_Evt const * const e) {
+    if (e->poolNum != 0U) { /* is it a dynamic event? */
+        uint8_t volatile *refCtr = &SST_EVT_CONST_CAST(e)->refCtr;
+        uint8_t ctr;
+        do {
+            ctr = SST_PORT_LOAD8(refCtr);
+            if (ctr <= 1U) { /* last reference? */
+                break; /* nobody else can take a new reference now */
+            }
+        } while (!SST_PORT_CAS8(refCtr, ctr, (uint8_t)(ctr - 1U)));
+
+        if (ctr <= 1U) { /* recycle the event */
+            uint_fast8_t idx = (uint_fast8_t)(e->poolNum - 1U);
+            /* the pool number must be valid */
+            DBC_ASSERT(800, idx < evtPools_num);
+
+            SST_PORT_CRIT_STAT
+            SST_PORT_CRIT_ENTRY();
+            --evtPools[idx].stat.nUsed;
+            SST_PORT_CRIT_EXIT();
+
+            (*evtPools[idx].put)(evtPools[idx].pool,
+                                 (void *)SST_EVT_CONST_CAST(e));
+        }
+    }
+}
+/*..........................................................................*/
+SST_EvtPoolStat const *SST_Evt_getPoolStat(uint8_t poolNum) {
+    /*! @pre the pool must have been added */
+    DBC_REQUIRE(900, (poolNum > 0U) && (poolNum <= evtPools_num));
+
+    return &evtPools[poolNum - 1U].stat;
 }
 
 /*--------------------------------------------------------------------------*/
-static SST_TimeEvt *timeEvt_head = (SST_TimeEvt *)0;
+/*! started tasks in descending priority order, the index of a task is its
+* bit in the subscriber lists (SST_Task.psBit)
+*/
+static SST_Task *ps_tasks[SST_PS_MAX_TASKS];
+static SST_TaskPrio ps_prio[SST_PS_MAX_TASKS];
+static uint_fast8_t ps_nTasks;
+
+static SST_SubscrList *ps_subscrList; /*! subscriber list of each signal */
+static SST_Signal ps_maxSignal;
+
+/*..........................................................................*/
+void SST_PubSub_init(SST_SubscrList * const subscrSto, SST_Signal maxSignal) {
+    /*! @pre
+    * - the subscriber lists must be provided
+    * - no task may be started yet
+    */
+    DBC_REQUIRE(1000,
+        (subscrSto != (SST_SubscrList *)0) && (ps_nTasks == 0U));
+
+    for (SST_Signal sig = 0U; sig < maxSignal; ++sig) {
+        subscrSto[sig] = 0U;
+    }
+    ps_subscrList = subscrSto;
+    ps_maxSignal = maxSignal;
+}
+/*..........................................................................*/
+static void SST_PubSub_register_(SST_Task * const me, SST_TaskPrio prio) {
+    /*! @pre the task must fit in the subscriber lists */
+    DBC_REQUIRE(1100, ps_nTasks < SST_PS_MAX_TASKS);
+
+    /* insertion sort by priority (descending), then start order */
+    uint_fast8_t i = ps_nTasks;
+    while ((i > 0U) && (ps_prio[i - 1U] < prio)) {
+        ps_tasks[i] = ps_tasks[i - 1U];
+        ps_prio[i] = ps_prio[i - 1U];
+        ps_tasks[i]->psBit = (uint8_t)i;
+        --i;
+    }
+    ps_tasks[i] = me;
+    ps_prio[i] = prio;
+    me->psBit = (uint8_t)i;
+    ++ps_nTasks;
+
+    /* the subscriptions of the tasks moved up follow them one bit up */
+    if (ps_subscrList != (SST_SubscrList *)0) {
+        SST_SubscrList below = ((SST_SubscrList)1U << i) - 1U;
+        for (SST_Signal sig = 0U; sig < ps_maxSignal; ++sig) {
+            SST_SubscrList list = ps_subscrList[sig];
+            ps_subscrList[sig] = (list & below) | ((list & ~below) << 1U);
+        }
+    }
+}
+/*..........................................................................*/
+void SST_Task_subscribe(SST_Task const * const me, SST_Signal sig) {
+    /*! @pre the signal must be in the range of SST_PubSub_init() */
+    DBC_REQUIRE(1200,
+        (ps_subscrList != (SST_SubscrList *)0) && (sig < ps_maxSignal));
+
+    SST_PORT_CRIT_STAT
+    SST_PORT_CRIT_ENTRY();
+    ps_subscrList[sig] |= ((SST_SubscrList)1U << me->psBit);
+    SST_PORT_CRIT_EXIT();
+}
+/*..........................................................................*/
+void SST_Task_unsubscribe(SST_Task const * const me, SST_Signal sig) {
+    /*! @pre the signal must be in the range of SST_PubSub_init() */
+    DBC_REQUIRE(1300,
+        (ps_subscrList != (SST_SubscrList *)0) && (sig < ps_maxSignal));
+
+    SST_PORT_CRIT_STAT
+    SST_PORT_CRIT_ENTRY();
+    ps_subscrList[sig] &= ~((SST_SubscrList)1U << me->psBit);
+    SST_PORT_CRIT_EXIT();
+}
+/*..........................................................................*/
+void SST_Task_publish(SST_Evt const * const e) {
+    /*! @pre the signal must be in the range of SST_PubSub_init() */
+    DBC_REQUIRE(1400,
+        (ps_subscrList != (SST_SubscrList *)0) && (e->sig < ps_maxSignal));
+
+    SST_SubscrList subscrs = *(SST_SubscrList volatile *)&ps_subscrList[e->sig];
+
+    /* hold a dynamic event until it was posted to every subscriber */
+    SST_Evt_ref(e);
+    if (subscrs != 0U) {
+        /* lock the scheduler up to the highest-priority subscriber, so that
+        * no subscriber runs before all of them have the event
+        */
+        SST_LockKey lock_key =
+            SST_Task_lock(ps_prio[__builtin_ctz(subscrs)]);
+        do {
+            SST_Task_post(ps_tasks[__builtin_ctz(subscrs)], e);
+            subscrs &= (subscrs - 1U); /* remove the lowest set bit */
+        } while (subscrs != 0U);
+        SST_Task_unlock(lock_key); /* subscribers run, highest prio first */
+    }
+    SST_Evt_gc(e); /* recycles the event if nobody subscribed */
+}
+
+/*--------------------------------------------------------------------------*/
+/*! the timing wheel, each slot lists the time events expiring in that slot */
+static SST_TimeEvt *timeEvt_wheel[SST_TIMEEVT_WHEEL_SIZE];
+
+/*! index of the wheel slot processed by the last tick */
+static uint_fast16_t timeEvt_pos;
+
+/* wheel helpers, must be called inside a critical section */
+static void SST_TimeEvt_insert_(SST_TimeEvt * const me, SST_TCtr ticks);
+static void SST_TimeEvt_remove_(SST_TimeEvt * const me);
 
 /*..........................................................................*/
 void SST_TimeEvt_ctor(
@@ -103,13 +404,14 @@ void SST_TimeEvt_ctor(
     SST_Task *task)
 {
     me->super.sig = sig;
+    me->super.poolNum = 0U; /* time events are static */
+    me->super.refCtr = 0U;
     me->task = task;
     me->ctr = 0U;
     me->interval = 0U;
-
-    /* insert time event "me" into the linked-list */
-    me->next = timeEvt_head;
-    timeEvt_head = me;
+    me->next = (SST_TimeEvt *)0;
+    me->prevNext = (SST_TimeEvt **)0;
+    me->expNext = (SST_TimeEvt *)0;
 }
 /*..........................................................................*/
 void SST_TimeEvt_arm(
@@ -119,8 +421,16 @@ void SST_TimeEvt_arm(
 {
     SST_PORT_CRIT_STAT
     SST_PORT_CRIT_ENTRY();
-    me->ctr = ctr;
+    if (me->ctr != 0U) { /* already armed? */
+        SST_TimeEvt_remove_(me);
+    }
     me->interval = interval;
+    if (ctr != 0U) {
+        SST_TimeEvt_insert_(me, ctr);
+    }
+    else { /* arming with zero ticks leaves the time event disarmed */
+        me->ctr = 0U;
+    }
     SST_PORT_CRIT_EXIT();
 }
 /*..........................................................................*/
@@ -128,6 +438,9 @@ bool SST_TimeEvt_disarm(SST_TimeEvt * const me) {
     SST_PORT_CRIT_STAT
     SST_PORT_CRIT_ENTRY();
     bool status = (me->ctr != 0U);
+    if (status) {
+        SST_TimeEvt_remove_(me);
+    }
     me->ctr = 0U;
     me->interval = 0U;
     SST_PORT_CRIT_EXIT();
@@ -135,24 +448,97 @@ bool SST_TimeEvt_disarm(SST_TimeEvt * const me) {
 }
 /*..........................................................................*/
 void SST_TimeEvt_tick(void) {
-    for (SST_TimeEvt *t = timeEvt_head;
-         t != (SST_TimeEvt *)0;
-         t = t->next)
-    {
-        SST_PORT_CRIT_STAT
-        SST_PORT_CRIT_ENTRY();
-        if (t->ctr == 0U) { /* disarmed? (most frequent case) */
-            SST_PORT_CRIT_EXIT();
+    SST_TimeEvt *expired = (SST_TimeEvt *)0;
+    SST_TimeEvt **expTail = &expired;
+
+    SST_PORT_CRIT_STAT
+    SST_PORT_CRIT_ENTRY();
+    timeEvt_pos = (timeEvt_pos + 1U) & (SST_TIMEEVT_WHEEL_SIZE - 1U);
+    SST_TimeEvt *t = timeEvt_wheel[timeEvt_pos];
+    while (t != (SST_TimeEvt *)0) {
+        SST_TimeEvt *next = t->next;
+        if (t->ctr > 1U) { /* due in a later turn of the wheel? */
+            --t->ctr;
         }
-        else if (t->ctr == 1U) { /* expiring? */
-            t->ctr = t->interval;
-            SST_PORT_CRIT_EXIT();
+        else { /* expiring */
+            SST_TimeEvt_remove_(t);
+            if (t->interval != 0U) { /* periodic? */
+                /* NOTE: re-inserted at the head of its slot, so it is not
+                * visited again by this loop even if it lands in this slot
+                */
+                SST_TimeEvt_insert_(t, t->interval);
+            }
+            else {
+                t->ctr = 0U;
+            }
+            /* collect in a separate list, a preempting task may re-arm
+            * the time event once the critical section is left
+            */
+            t->expNext = (SST_TimeEvt *)0;
+            *expTail = t;
+            expTail = &t->expNext;
+        }
+        t = next;
+    }
+    SST_PORT_CRIT_EXIT();
 
-            SST_Task_post(t->task, &t->super);
+    /* post the expired time events outside the critical section */
+    for (t = expired; t != (SST_TimeEvt *)0; t = t->expNext) {
+        SST_Task_post(t->task, &t->super);
+    }
+}
+/*..........................................................................*/
+SST_TCtr SST_TimeEvt_nextTick(void) {
+    uint32_t best = 0U; /* no time event armed */
+
+    /* visit the slots in expiry order, starting with the next tick */
+    for (uint_fast16_t dist = 1U; dist <= SST_TIMEEVT_WHEEL_SIZE; ++dist) {
+        if ((best != 0U) && (dist >= best)) {
+            break; /* no later slot can expire sooner */
         }
-        else { /* timing out */
-            --t->ctr;
-            SST_PORT_CRIT_EXIT();
+        uint_fast16_t slot = (timeEvt_pos + dist)
+                             & (SST_TIMEEVT_WHEEL_SIZE - 1U);
+        for (SST_TimeEvt const *t = timeEvt_wheel[slot];
+             t != (SST_TimeEvt *)0;
+             t = t->next)
+        {
+            uint32_t ticks = dist
+                + ((uint32_t)(t->ctr - 1U) * SST_TIMEEVT_WHEEL_SIZE);
+            if ((best == 0U) || (ticks < best)) {
+                best = ticks;
+            }
         }
     }
+    return (SST_TCtr)best;
+}
+/*..........................................................................*/
+void SST_TimeEvt_catchUp(SST_TCtr ticks) {
+    /* NOTE: the tick source is suppressed only until the earliest expiry,
+    * so the skipped ticks normally just advance the wheel
+    */
+    for (; ticks != 0U; --ticks) {
+        SST_TimeEvt_tick();
+    }
+}
+/*..........................................................................*/
+static void SST_TimeEvt_insert_(SST_TimeEvt * const me, SST_TCtr ticks) {
+    uint_fast16_t slot = (timeEvt_pos + ticks)
+                         & (SST_TIMEEVT_WHEEL_SIZE - 1U);
+    me->ctr = (SST_TCtr)(((ticks - 1U) / SST_TIMEEVT_WHEEL_SIZE) + 1U);
+
+    me->next = timeEvt_wheel[slot];
+    if (me->next != (SST_TimeEvt *)0) {
+        me->next->prevNext = &me->next;
+    }
+    me->prevNext = &timeEvt_wheel[slot];
+    timeEvt_wheel[slot] = me;
+}
+/*..........................................................................*/
+static void SST_TimeEvt_remove_(SST_TimeEvt * const me) {
+    *me->prevNext = me->next;
+    if (me->next != (SST_TimeEvt *)0) {
+        me->next->prevNext = me->prevNext;
+    }
+    me->next = (SST_TimeEvt *)0;
+    me->prevNext = (SST_TimeEvt **)0;
 }
@@ -34,11 +34,28 @@ DBC_MODULE_NAME("sst_port") /* for DBC assertions in this module */
 #define SCB_SYSPRI   ((uint32_t volatile *)0xE000ED14U)
 #define SCB_AIRCR   *((uint32_t volatile *)0xE000ED0CU)
 #define FPU_FPCCR   *((uint32_t volatile *)0xE000EF34U)
+#define DEMCR       *((uint32_t volatile *)0xE000EDFCU)
+#define DWT_CTRL    *((uint32_t volatile *)0xE0001000U)
+#define SYST_CSR    *((uint32_t volatile *)0xE000E010U)
+#define SYST_RVR    *((uint32_t volatile *)0xE000E014U)
+#define SYST_CVR    *((uint32_t volatile *)0xE000E018U)
+#define SCB_ICSR    *((uint32_t volatile *)0xE000ED04U)
+
+#define SYST_CSR_ENABLE    (1U << 0U)
+#define SYST_CSR_COUNTFLAG (1U << 16U)
+#define SYST_RVR_MAX       0x00FFFFFFU
+#define SCB_ICSR_PENDSTSET (1U << 26U)
 
 /*..........................................................................*/
 /* # of unused interrupt priority bits in NVIC */
 static uint32_t nvic_prio_shift;
 
+/* SysTick cycles per tick for tickless idle (0 when disabled) */
+static uint32_t tickless_cycles;
+
+/* ticks skipped by tickless idle, not yet taken by the SysTick ISR */
+static uint32_t volatile tickless_skipped;
+
 /* SST kernel facilities ---------------------------------------------------*/
 void SST_init(void) {
     /* determine number of NVIC priority bits by writing 0xFF to the
@@ -62,6 +79,12 @@ void SST_init(void) {
     FPU_FPCCR |= (1U << 30U)    /* automatic FPU state preservation (ASPEN) */
                  | (1U << 31U); /* lazy stacking (LSPEN) */
 #endif
+
+#if (SST_TASK_STATS != 0)
+    /* start the DWT cycle counter for the task statistics */
+    DEMCR |= (1U << 24U);   /* enable the DWT (TRCENA) */
+    DWT_CTRL |= (1U << 0U); /* enable the cycle counter (CYCCNTENA) */
+#endif
 }
 /*..........................................................................*/
 void SST_start(void) {
@@ -79,6 +102,25 @@ void SST_start(void) {
     SCB_AIRCR = (0x05FAU << 16U) | tmp;
 }
 
+/*..........................................................................*/
+uint8_t SST_PORT_currPrio(void) {
+    uint32_t exc = SST_PORT_currCtx();
+    if (exc == 0U) { /* thread mode? */
+        return 0U;
+    }
+    if (exc < 16U) { /* system exception (SysTick, PendSV, faults...)? */
+        return SST_PORT_PRIO_ISR;
+    }
+    /* invert the SST_Task_setPrio() mapping of the IRQ's NVIC priority */
+    uint32_t nvic_prio = ((uint8_t volatile *)NVIC_IP)[exc - 16U]
+                         >> nvic_prio_shift;
+    if (nvic_prio == 0U) { /* above any task priority? */
+        return SST_PORT_PRIO_ISR;
+    }
+    uint32_t prio = (0xFFU >> nvic_prio_shift) + 1U - nvic_prio;
+    return (prio < SST_PORT_PRIO_ISR) ? (uint8_t)prio : SST_PORT_PRIO_ISR;
+}
+
 /* SST Task facilities -----------------------------------------------------*/
 void SST_Task_setPrio(SST_Task * const me, SST_TaskPrio prio) {
 
@@ -112,30 +154,44 @@ void SST_Task_setPrio(SST_Task * const me, SST_TaskPrio prio) {
 }
 /*..........................................................................*/
 void SST_Task_activate(SST_Task * const me) {
-    /*! @pre the queue must have some events */
-    DBC_REQUIRE(300, me->nUsed > 0U);
+    SST_QCtr nBatch = me->batch; /* events left in this activation */
+    bool more;
+    do {
+        /* get the event out of the queue */
+        /* NOTE: no critical section because me->tail is accessed only
+        * from this task. An empty entry was reserved by a producer that
+        * has not stored its event yet (that producer pends the task again)
+        * or this activation was pended for an event already drained by a
+        * previous batch.
+        */
+        SST_Evt const *e = SST_PORT_EVT_LOAD(&me->qBuf[me->tail]);
+        if (e == (SST_Evt const *)0) {
+            break;
+        }
+        SST_PORT_EVT_STORE(&me->qBuf[me->tail], (SST_Evt const *)0);
+        if (me->tail == 0U) { /* need to wrap the tail? */
+            me->tail = me->end; /* wrap around */
+        }
+        else {
+            --me->tail;
+        }
+        --nBatch;
 
-    /* get the event out of the queue */
-    /* NOTE: no critical section because me->tail is accessed only
-    * from this task
-    */
-    SST_Evt const *e = me->qBuf[me->tail];
-    if (me->tail == 0U) { /* need to wrap the tail? */
-        me->tail = me->end; /* wrap around */
-    }
-    else {
-        --me->tail;
-    }
-    SST_PORT_CRIT_STAT
-    SST_PORT_CRIT_ENTRY();
-    if ((--me->nUsed) > 0U) { /* some events still present in the queue? */
-        *me->nvic_pend = me->nvic_irq; /* <=== pend the associated IRQ */
-    }
-    SST_PORT_CRIT_EXIT();
+        SST_QCtr nUsed;
+        do { /* release the entry for the producers */
+            nUsed = SST_PORT_LOAD8(&me->nUsed);
+        } while (!SST_PORT_CAS8(&me->nUsed, nUsed, (SST_QCtr)(nUsed - 1U)));
+        more = (nUsed > 1U); /* some events still present in the queue? */
+        if (more && (nBatch == 0U)) { /* batch used up? */
+            *me->nvic_pend = me->nvic_irq; /* <=== pend the associated IRQ */
+        }
 
-    /* dispatch the received event to this task */
-    (*me->dispatch)(me, e); /* NOTE: virtual call */
-    /* TBD: implement event recycling */
+        /* dispatch the received event to this task */
+        SST_TASK_STAT_BEGIN(t0);
+        (*me->dispatch)(me, e); /* NOTE: virtual call */
+        SST_TASK_STAT_END(me, nUsed, t0);
+        SST_Evt_gc(e); /* recycle the event, if dynamic */
+    } while (more && (nBatch > 0U));
 }
 /*..........................................................................*/
 void SST_Task_setIRQ(SST_Task * const me, uint8_t irq) {
@@ -164,7 +220,8 @@ SST_LockKey SST_Task_lock(SST_TaskPrio ceiling) {
                          << nvic_prio_shift;
     SST_LockKey basepri_; /* initialized in the following asm() instruction */
     __asm volatile ("mrs %0,BASEPRI" : "=r" (basepri_) :: );
-    if (basepri_ > nvic_prio) { /* current priority lower than the ceiling? */
+    /* BASEPRI of 0 masks nothing, i.e. the lowest possible level */
+    if ((basepri_ == 0U) || (basepri_ > nvic_prio)) { /* below the ceiling? */
         __asm volatile ("cpsid i\n msr BASEPRI,%0\n cpsie i"
                         :: "r" (nvic_prio) : );
     }
@@ -185,9 +242,87 @@ void SST_Task_unlock(SST_LockKey lock_key) {
 #endif
 }
 
-void SST_onIdle(void)
-{
-	/*__WFI();*/
+void SST_PORT_setTickless(bool enable) {
+    /* capture the tick period SysTick was configured with */
+    tickless_cycles = enable ? (SYST_RVR + 1U) : 0U;
+}
+/*..........................................................................*/
+void SST_onIdle(void) {
+    if (tickless_cycles == 0U) { /* tickless idle disabled? */
+        return;
+    }
+
+    __asm volatile ("cpsid i");
+    uint32_t next = SST_TimeEvt_nextTick();
+    uint32_t cycles_left = SYST_CVR; /* remaining cycles of current tick */
+    uint32_t max_ticks = ((SYST_RVR_MAX - cycles_left) / tickless_cycles)
+                         + 1U;
+    if ((next == 0U) || (next > max_ticks)) { /* nothing armed or too far? */
+        next = max_ticks;
+    }
+    if (next < 2U) { /* the next tick is due anyway */
+        __asm volatile ("cpsie i");
+        return;
+    }
+
+    /* reprogram SysTick to expire at the tick of the earliest time event */
+    uint32_t period = cycles_left + ((next - 1U) * tickless_cycles);
+    SYST_CSR &= ~SYST_CSR_ENABLE;
+    SYST_RVR = period - 1U;
+    SYST_CVR = 0U; /* reload from RVR when enabled */
+    SYST_CSR |= SYST_CSR_ENABLE;
+
+    /* NOTE: WFI wakes up on a pending interrupt even with PRIMASK set */
+    __asm volatile ("dsb" ::: "memory");
+    __asm volatile ("wfi");
+    __asm volatile ("isb");
+
+    uint32_t csr = SYST_CSR; /* NOTE: reading clears the COUNTFLAG */
+    SYST_CSR = csr & ~SYST_CSR_ENABLE;
+
+    uint32_t elapsed;   /* tick boundaries crossed, not yet signalled */
+    uint32_t skipped;   /* of those, the ones the SysTick ISR catches up */
+    uint32_t remaining; /* cycles to the next tick boundary */
+    if ((csr & SYST_CSR_COUNTFLAG) != 0U) { /* slept all the way? */
+        /* the pending SysTick interrupt signals the last tick */
+        elapsed = next - 1U;
+        skipped = elapsed;
+        remaining = tickless_cycles;
+    }
+    else { /* woken up early by another interrupt */
+        uint32_t done = (period - 1U) - SYST_CVR;
+        if (done < cycles_left) {
+            elapsed = 0U;
+            skipped = 0U;
+            remaining = cycles_left - done;
+        }
+        else {
+            done -= cycles_left;
+            elapsed = 1U + (done / tickless_cycles);
+            skipped = elapsed - 1U;
+            remaining = tickless_cycles - (done % tickless_cycles);
+            /* the SysTick ISR pended here signals the last crossed tick */
+            SCB_ICSR = SCB_ICSR_PENDSTSET;
+        }
+    }
+
+    /* run the partial tick, then restore the regular tick period */
+    SYST_RVR = remaining - 1U;
+    SYST_CVR = 0U;
+    SYST_CSR |= SYST_CSR_ENABLE;
+    SYST_RVR = tickless_cycles - 1U; /* used from the next reload on */
+
+    /* NOTE: the catch-up runs in the SysTick ISR, pending by now if any tick
+    * was crossed, so it never races the tick it would otherwise preempt
+    */
+    tickless_skipped += skipped;
+    __asm volatile ("cpsie i");
+}
+/*..........................................................................*/
+uint32_t SST_PORT_ticklessSkipped(void) {
+    uint32_t skipped = tickless_skipped;
+    tickless_skipped = 0U;
+    return skipped;
 }
 
 void SST_onStart(void){
@@ -183,7 +183,10 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  uint32_t skipped = SST_PORT_ticklessSkipped();
+  if (skipped != 0U) { /* ticks slept through by the tickless idle */
+    SST_onTicklessWake((SST_TCtr)skipped);
+  }
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
 
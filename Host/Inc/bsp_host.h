@@ -0,0 +1,38 @@
+/*
+ * bsp_host.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Host (Linux) board support, the counterpart of bsp.c for the POSIX SST port.
+ */
+
+#ifndef HOST_BSP_HOST_H_
+#define HOST_BSP_HOST_H_
+
+#include <stdint.h>
+
+/*number of simulated milliseconds to run before printing the statistics and exiting*/
+void BSP_host_setRunTime(uint32_t run_ms);
+
+/*suppress the simulated 1ms tick while idle and wake only at the next time event*/
+void BSP_host_setTickless(uint8_t enable);
+
+/*drive the SPI manager transfers with the simulated DMA streams instead of a byte per interrupt*/
+void BSP_host_setSpiDma(uint8_t enable);
+
+/*drive the SPI manager transfers with its register engine on the simulated SPI1 registers*/
+void BSP_host_setSpiReg(uint8_t enable);
+
+/*lose the given share (per mille) of the simulated SPI complete interrupts, the SPI manager
+ *recovers through its job timeouts and retries*/
+void BSP_host_setSpiDropRate(uint32_t perMille);
+
+/*print the per task statistics as key=value lines*/
+void BSP_host_report(void);
+
+/*run the named host benchmark (see bench_host.c), "all" runs every benchmark.
+ *results are printed as key=value lines, returns 0 on success*/
+int BSP_host_bench(char const *name);
+
+#endif /* HOST_BSP_HOST_H_ */
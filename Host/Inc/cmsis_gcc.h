@@ -0,0 +1,20 @@
+/*
+ * cmsis_gcc.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Host stand-in for the CMSIS GCC intrinsics used by the application modules.
+ */
+
+#ifndef HOST_CMSIS_GCC_H_
+#define HOST_CMSIS_GCC_H_
+
+#include <stdint.h>
+
+/*count leading zeros, returns 32 for a zero value like the Cortex-M CLZ instruction*/
+static inline uint8_t __CLZ(uint32_t value) {
+	return (value == 0u) ? 32u : (uint8_t) __builtin_clz(value);
+}
+
+#endif /* HOST_CMSIS_GCC_H_ */
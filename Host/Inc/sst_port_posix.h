@@ -0,0 +1,152 @@
+/*===========================================================================
+* Super-Simple Tasker (SST/C) port to a POSIX host (Linux)
+*
+* SPDX-License-Identifier: MIT
+*
+* The host port replaces the NVIC of the ARM Cortex-M port with a software
+* priority scheduler. All tasks and all simulated interrupts execute on the
+* single thread that calls SST_Task_run(), so the run-to-completion and
+* preemption rules are the same as on the target:
+* - a post to a higher priority task preempts the poster as soon as the
+*   critical section is left (the equivalent of "cpsie i" taking the IRQ),
+* - tasks of equal priority are ordered by their IRQ number, like the NVIC,
+* - code bracketed by SST_PORT_isrEntry()/SST_PORT_isrExit() behaves like
+*   an ISR and is never preempted by tasks.
+* SST_Task_post() is lock-free and may also be called from other threads
+* (e.g. to stress the event queues). Such posts only mark the task ready,
+* the task runs on the SST thread at its next scheduling point.
+===========================================================================*/
+#ifndef SST_PORT_POSIX_H_
+#define SST_PORT_POSIX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct SST_Task; /* forward declaration, see sst.h */
+
+/* maximum number of tasks handled by the host scheduler */
+#define SST_PORT_MAX_TASKS (32U)
+
+/* per-task statistics (SST_Task_getStat) are on by default on the host */
+#ifndef SST_TASK_STATS
+#define SST_TASK_STATS 1
+#endif
+
+#if (SST_TASK_STATS != 0)
+#define SST_PORT_TASK_STAT_ATTR SST_TaskStat stat;
+#else
+#define SST_PORT_TASK_STAT_ATTR
+#endif
+
+/* time-stamp of the task statistics: monotonic host clock [ns] */
+#define SST_PORT_STAT_TIME() ((uint32_t)SST_PORT_now_ns())
+
+/* context running now, numbered like the Cortex-M IPSR: 16 + IRQ of the
+* running task, SST_PORT_ISR_CTX in a simulated ISR, 0 otherwise (main, idle)
+*/
+#define SST_PORT_ISR_CTX (15U)
+#define SST_PORT_CURR_CTX() SST_PORT_currCtx()
+uint16_t SST_PORT_currCtx(void);
+
+/* SST priority of the running context: the task priority, 0 in the main
+* thread, SST_PORT_PRIO_ISR in a simulated ISR. Contexts of the same
+* priority never preempt each other (other threads don't count).
+*/
+#define SST_PORT_PRIO_ISR (0xFFU)
+#define SST_PORT_CURR_PRIO() SST_PORT_currPrio()
+uint8_t SST_PORT_currPrio(void);
+
+/* post-to-dispatch statistics collected by the host port for every task */
+typedef struct {
+    uint32_t nDispatch;   /*!< # events dispatched to the task */
+    uint32_t nActivate;   /*!< # activations ("IRQ entries") of the task */
+    uint64_t latTotal_ns; /*!< sum of all post-to-dispatch latencies */
+    uint64_t latMax_ns;   /*!< worst post-to-dispatch latency */
+} SST_PortStat;
+
+/* additional SST-PORT task attributes for the POSIX host */
+#define SST_PORT_TASK_ATTR \
+    uint32_t pend_bit;     /* ready-set bit of this task */ \
+    uint8_t irq;           /* simulated IRQ (orders equal priorities) */ \
+    SST_TaskPrio prio;     /* SST priority of the task */ \
+    uint64_t post_ns[256]; /* post time-stamp of every qBuf entry */ \
+    SST_PortStat portStat; \
+    SST_PORT_TASK_STAT_ATTR
+
+/* additional SST-PORT task operations for the POSIX host */
+#define SST_PORT_TASK_OPER \
+    void SST_Task_activate(SST_Task * const me); \
+    void SST_Task_setIRQ(SST_Task * const me, uint8_t irq); \
+    void SST_Task_setPrio(SST_Task * const me, SST_TaskPrio prio); \
+    SST_PortStat const *SST_Task_getPortStat(SST_Task const * const me);
+
+/* SST-PORT critical section
+* NOTE: the host critical section only defers the scheduler, because
+* everything runs on one thread. Leaving the outermost critical section
+* runs any task that became ready above the current priority.
+*/
+#define SST_PORT_CRIT_STAT
+#define SST_PORT_CRIT_ENTRY() SST_PORT_critEntry()
+#define SST_PORT_CRIT_EXIT()  SST_PORT_critExit()
+
+/* SST-PORT time-stamp the queue entry 'head' claimed by SST_Task_post()
+* NOTE: executed before the event is stored (published with a release
+* store), so a consumer that sees the event also sees its time-stamp.
+*/
+#define SST_PORT_TASK_CLAIM() \
+    __atomic_store_n(&me->post_ns[head], SST_PORT_now_ns(), __ATOMIC_RELAXED)
+
+/* SST-PORT pend the Task after posting an event
+* NOTE: executed outside any critical section, right after SST_Task_post()
+* stored the event in the queue entry 'head'.
+*/
+#define SST_PORT_TASK_PEND()  SST_PORT_taskPend(me)
+
+/* SST-PORT lock-free primitives of the event queues (see SST_Task_post)
+* NOTE: the GCC builtins follow the C11 memory model (<stdatomic.h>).
+*/
+#define SST_PORT_LOAD8(p_) __atomic_load_n((p_), __ATOMIC_RELAXED)
+#define SST_PORT_CAS8(p_, old_, new_) SST_PORT_cas8((p_), (old_), (new_))
+#define SST_PORT_EVT_STORE(p_, e_) \
+    __atomic_store_n((p_), (e_), __ATOMIC_RELEASE)
+#define SST_PORT_EVT_LOAD(p_) __atomic_load_n((p_), __ATOMIC_ACQUIRE)
+
+/* compare-and-swap of a byte, returns true if *p was old and is now new_ */
+static inline bool SST_PORT_cas8(uint8_t volatile * const p,
+                                 uint8_t old, uint8_t new_)
+{
+    return __atomic_compare_exchange_n(p, &old, new_, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/* SST-PORT lock-free primitives of 32-bit words (see mpool_lf_t) */
+#define SST_PORT_LOAD32(p_) __atomic_load_n((p_), __ATOMIC_ACQUIRE)
+#define SST_PORT_STORE32(p_, v_) __atomic_store_n((p_), (v_), __ATOMIC_RELAXED)
+#define SST_PORT_CAS32(p_, old_, new_) SST_PORT_cas32((p_), (old_), (new_))
+
+/* compare-and-swap of a word, returns true if *p was old and is now new_ */
+static inline bool SST_PORT_cas32(uint32_t volatile * const p,
+                                  uint32_t old, uint32_t new_)
+{
+    return __atomic_compare_exchange_n(p, &old, new_, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+void SST_PORT_critEntry(void);
+void SST_PORT_critExit(void);
+void SST_PORT_taskPend(struct SST_Task * const me);
+
+/* bracket code that simulates an interrupt service routine */
+void SST_PORT_isrEntry(void);
+void SST_PORT_isrExit(void);
+
+/* monotonic host time-stamp [ns] used for the port statistics */
+uint64_t SST_PORT_now_ns(void);
+
+/* the idle SST callback for this SST port */
+void SST_onIdle(void);
+
+/* the SST scheduler lock key type */
+typedef uint32_t SST_LockKey;
+
+#endif /* SST_PORT_POSIX_H_ */
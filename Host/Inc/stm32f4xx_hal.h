@@ -0,0 +1,229 @@
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Host stand-in for the STM32F4 HAL. Provides only the types and calls used by the
+ *      application modules (GPIO chip selects and the interrupt or DMA driven SPI transfers) so
+ *      that they build unchanged against the POSIX SST port. SPI transfers are clocked through a
+ *      simulated slave device when the host board calls HAL_host_SPI_IRQHandler() (interrupt
+ *      mode, one call per byte) or HAL_host_DMA_IRQHandler() (DMA mode, one call per transfer).
+ *      Code that drives the SPI registers itself runs against a model of SPIx->SR and SPIx->DR.
+ */
+
+#ifndef HOST_STM32F4XX_HAL_H_
+#define HOST_STM32F4XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+	HAL_OK = 0x00U, HAL_ERROR = 0x01U, HAL_BUSY = 0x02U, HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+/***************************************Tick*****************************************/
+void HAL_IncTick(void); /*called from the simulated SysTick*/
+uint32_t HAL_GetTick(void);
+
+/***************************************GPIO*****************************************/
+typedef struct {
+	uint32_t ODR; /*output data register*/
+} GPIO_TypeDef;
+
+typedef enum {
+	GPIO_PIN_RESET = 0, GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_1  ((uint16_t)0x0002)
+#define GPIO_PIN_2  ((uint16_t)0x0004)
+#define GPIO_PIN_3  ((uint16_t)0x0008)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_6  ((uint16_t)0x0040)
+#define GPIO_PIN_7  ((uint16_t)0x0080)
+#define GPIO_PIN_8  ((uint16_t)0x0100)
+#define GPIO_PIN_9  ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+extern GPIO_TypeDef HAL_host_GPIO[8];
+#define GPIOA (&HAL_host_GPIO[0])
+#define GPIOB (&HAL_host_GPIO[1])
+#define GPIOC (&HAL_host_GPIO[2])
+#define GPIOD (&HAL_host_GPIO[3])
+#define GPIOE (&HAL_host_GPIO[4])
+#define GPIOF (&HAL_host_GPIO[5])
+#define GPIOG (&HAL_host_GPIO[6])
+#define GPIOH (&HAL_host_GPIO[7])
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+		GPIO_PinState PinState);
+
+/***************************************SPI******************************************/
+typedef enum {
+	HAL_SPI_STATE_RESET = 0x00U,
+	HAL_SPI_STATE_READY = 0x01U,
+	HAL_SPI_STATE_BUSY_TX = 0x03U,
+	HAL_SPI_STATE_BUSY_RX = 0x04U,
+	HAL_SPI_STATE_BUSY_TX_RX = 0x05U,
+	HAL_SPI_STATE_ABORT = 0x07U
+} HAL_SPI_StateTypeDef;
+
+typedef enum {
+	HAL_DMA_STATE_RESET = 0x00U,
+	HAL_DMA_STATE_READY = 0x01U,
+	HAL_DMA_STATE_BUSY = 0x02U
+} HAL_DMA_StateTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+	HAL_DMA_StateTypeDef State;
+	void *Parent; /*SPI handle the stream serves, see __HAL_LINKDMA*/
+} DMA_HandleTypeDef;
+
+/*SPI registers, a model of the status and data registers (see HAL_host_SPI_readSR) for code
+ *that drives the peripheral directly*/
+typedef struct {
+	uint32_t CR1;
+	uint32_t CR2;
+	uint32_t SR;
+	uint32_t DR; /*received byte*/
+	uint16_t hostByteTime; /*host: status register reads a byte takes on the bus, 0 for instant*/
+	uint16_t hostBusy; /*host: reads left of the byte on the bus*/
+	uint32_t hostAccesses; /*host: status and data register accesses*/
+} SPI_TypeDef;
+
+#define SPI_CR1_CPHA (0x1UL << 0)
+#define SPI_CR1_CPOL (0x1UL << 1)
+#define SPI_CR1_BR (0x7UL << 3) /*baud rate prescaler*/
+#define SPI_CR1_SPE (0x1UL << 6) /*SPI enable*/
+#define SPI_CR1_DFF (0x1UL << 11) /*16 bit frames*/
+#define SPI_CR2_RXNEIE (0x1UL << 6) /*RX buffer not empty interrupt enable*/
+#define SPI_SR_RXNE (0x1UL << 0)
+#define SPI_SR_TXE (0x1UL << 1)
+#define SPI_SR_OVR (0x1UL << 6)
+#define SPI_SR_BSY (0x1UL << 7)
+
+extern SPI_TypeDef HAL_host_SPI[3];
+#define SPI1 (&HAL_host_SPI[0])
+#define SPI2 (&HAL_host_SPI[1])
+#define SPI3 (&HAL_host_SPI[2])
+
+/*the bus settings of SPI_InitTypeDef, the values are the SPI_CR1 bits*/
+typedef struct {
+	uint32_t DataSize;
+	uint32_t CLKPolarity;
+	uint32_t CLKPhase;
+	uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+#define SPI_DATASIZE_8BIT (0x00000000U)
+#define SPI_DATASIZE_16BIT SPI_CR1_DFF
+#define SPI_POLARITY_LOW (0x00000000U)
+#define SPI_POLARITY_HIGH SPI_CR1_CPOL
+#define SPI_PHASE_1EDGE (0x00000000U)
+#define SPI_PHASE_2EDGE SPI_CR1_CPHA
+#define SPI_BAUDRATEPRESCALER_2 (0x00000000U)
+#define SPI_BAUDRATEPRESCALER_4 (0x1UL << 3)
+#define SPI_BAUDRATEPRESCALER_8 (0x2UL << 3)
+#define SPI_BAUDRATEPRESCALER_16 (0x3UL << 3)
+#define SPI_BAUDRATEPRESCALER_32 (0x4UL << 3)
+#define SPI_BAUDRATEPRESCALER_64 (0x5UL << 3)
+#define SPI_BAUDRATEPRESCALER_128 (0x6UL << 3)
+#define SPI_BAUDRATEPRESCALER_256 (0x7UL << 3)
+
+typedef struct __SPI_HandleTypeDef {
+	SPI_TypeDef *Instance;
+	SPI_InitTypeDef Init;
+	uint8_t *pTxBuffPtr;
+	uint8_t *pRxBuffPtr;
+	uint16_t XferSize;
+	uint16_t XferCount; /*bytes left*/
+	DMA_HandleTypeDef *hdmatx;
+	DMA_HandleTypeDef *hdmarx;
+	HAL_SPI_StateTypeDef State;
+	uint8_t hostDma; /*host: the transfer in progress runs on the DMA streams*/
+	/*host: completion callback of this handle, the global HAL_SPI_*CpltCallback when NULL (as with
+	 *USE_HAL_SPI_REGISTER_CALLBACKS, lets benchmarks own a handle of their own)*/
+	void (*hostCpltCallback)(struct __SPI_HandleTypeDef *hspi);
+} SPI_HandleTypeDef;
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+	do { \
+		(__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); \
+		(__DMA_HANDLE__).Parent = (__HANDLE__); \
+	} while (0)
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi,
+		uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+
+HAL_StatusTypeDef HAL_SPI_Transmit_IT(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size);
+
+HAL_StatusTypeDef HAL_SPI_Receive_IT(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size);
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi,
+		uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size);
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size);
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi);
+
+/*implemented by the application, as with the real HAL*/
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi);
+
+/***********************************host simulation**********************************/
+
+/*simulated slave: clocks len bytes out of tx and into rx while its chip select is low. first is 1
+ *for the first bytes after the chip select went low, 0 when a transfer continues the frame*/
+typedef void (*HAL_host_SPISlave_t)(void *pSlave, uint8_t const *tx, uint8_t *rx,
+		uint16_t len, int first);
+
+void HAL_host_SPI_attach(GPIO_TypeDef *pcsGPIOPort, uint16_t csGPIOPin,
+		HAL_host_SPISlave_t xfer, void *pSlave);
+
+/*SPI interrupt of an interrupt mode transfer: clocks the next byte, on the last one completes the
+ *transfer and calls the complete callback of its kind. Call from a simulated ISR, returns 1 if a
+ *byte was clocked (0 when idle or the transfer runs on DMA)*/
+int HAL_host_SPI_IRQHandler(SPI_HandleTypeDef *hspi);
+
+/*register model: a data register write clocks the byte through the selected slaves (it is on the
+ *bus for hostByteTime status register reads, then RXNE is set and the byte received can be read),
+ *a data register read clears RXNE. Every access counts in hostAccesses*/
+uint32_t HAL_host_SPI_readSR(SPI_TypeDef *SPIx);
+void HAL_host_SPI_writeDR(SPI_TypeDef *SPIx, uint8_t data);
+uint8_t HAL_host_SPI_readDR(SPI_TypeDef *SPIx);
+
+/*the SPI manager register engine goes through the model*/
+#define SPIMANAGER_SPI_SR(regs_) HAL_host_SPI_readSR(regs_)
+#define SPIMANAGER_SPI_DR_WRITE(regs_, data_) HAL_host_SPI_writeDR((regs_), (uint8_t) (data_))
+#define SPIMANAGER_SPI_DR_READ(regs_) HAL_host_SPI_readDR(regs_)
+
+/*RXNE interrupt of the register model: finishes the byte on the bus, returns 1 if RXNE is set with
+ *RXNEIE enabled, i.e. the SPI interrupt is taken. Call from a simulated ISR*/
+int HAL_host_SPI_regIRQ(SPI_TypeDef *SPIx);
+
+/*lost interrupts: the given share (per mille) of HAL transfers finish without their complete
+ *callback, picked by a fixed pseudo random sequence so runs repeat. 0 (the default) drops none*/
+void HAL_host_SPI_setDropRate(uint32_t perMille);
+
+/*transfer complete interrupt of a DMA stream: clocks the whole transfer of the SPI handle it serves
+ *(the rx stream, or the tx stream of a transmit only transfer) and calls the complete callback.
+ *Call from a simulated ISR, returns 1 if a transfer was completed*/
+int HAL_host_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+#endif /* HOST_STM32F4XX_HAL_H_ */
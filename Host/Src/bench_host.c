@@ -0,0 +1,1446 @@
+/*
+ * bench_host.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Host benchmarks of the SST kernel and application modules. Each benchmark prints its
+ *      results as key=value lines (one line per measurement point) so they can be plotted or
+ *      compared between commits. Run with: sst_host bench [name|all]
+ */
+
+#define _POSIX_C_SOURCE 200809L /* pthreads */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "sst.h"
+#include "bsp_host.h"
+#include "bsp.h"
+#include "spi_manager.h"
+#include "LIS3DSH.h"
+#include "mempool.h"
+#include "devnt.h"
+#include "poolbench.h"
+
+typedef void (*BSP_host_bench_t)(void);
+
+/*SIGALRM period of the benchmarks that preempt code like an ISR, the kernel delivers it as fast
+ *as it can*/
+#define BENCH_ISR_PERIOD_US (20)
+
+/*****************************SST_TimeEvt_tick cost************************/
+#define BENCH_TICK_MAX_TIMERS (1000u)
+#define BENCH_TICK_TICKS (20000u) /*ticks measured per point*/
+
+static SST_TimeEvt benchTimers[BENCH_TICK_MAX_TIMERS];
+static SST_Task benchTickTask; /*owner of the timers, never posted to*/
+
+static uint64_t bench_tick_run(void) {
+	uint64_t start_ns = SST_PORT_now_ns();
+	for (uint32_t i = 0u; i < BENCH_TICK_TICKS; i++) {
+		SST_TimeEvt_tick();
+	}
+	return SST_PORT_now_ns() - start_ns;
+}
+
+/*cost of one tick against the number of constructed timers, either all disarmed or all armed
+ *with a timeout beyond the measurement (so the wheel slots fill up but nothing expires)*/
+static void bench_timeevt_tick(void) {
+	static const uint32_t numTimers[] = { 1u, 2u, 5u, 10u, 20u, 50u, 100u,
+			200u, 500u, 1000u };
+
+	for (uint32_t n = 0u; n < ARRAY_NELEM(numTimers); n++) {
+		for (uint32_t i = 0u; i < numTimers[n]; i++) {
+			SST_TimeEvt_ctor(&benchTimers[i], 0u, &benchTickTask);
+		}
+		uint64_t disarmed_ns = bench_tick_run();
+
+		for (uint32_t i = 0u; i < numTimers[n]; i++) {
+			SST_TimeEvt_arm(&benchTimers[i],
+					(SST_TCtr) (BENCH_TICK_TICKS * 2u + i), 0u);
+		}
+		uint64_t armed_ns = bench_tick_run();
+
+		for (uint32_t i = 0u; i < numTimers[n]; i++) {
+			SST_TimeEvt_disarm(&benchTimers[i]);
+		}
+		printf("bench=timeevt_tick timers=%lu disarmed_ns_per_tick=%.2f armed_ns_per_tick=%.2f\n",
+				(unsigned long) numTimers[n],
+				(double) disarmed_ns / BENCH_TICK_TICKS,
+				(double) armed_ns / BENCH_TICK_TICKS);
+	}
+}
+
+/*****************************SPI manager request flood************************/
+#define BENCH_FLOOD_LEN (15u) /*requests per burst, fits the manager job queue*/
+#define BENCH_FLOOD_ROUNDS (20000u)
+
+static SPIManager_Task_t benchSpiMgr;
+static SST_Evt const *benchSpiMgrQueue[BENCH_FLOOD_LEN + 1u];
+static SPI_HandleTypeDef benchSpi;
+static SPI_TypeDef benchSpiRegs = { .SR = SPI_SR_TXE }; /*registers of benchSpi (register model)*/
+
+static SST_Task benchRequester; /*receives the SPI_TXRXCOMPLETE_SIG responses*/
+static SST_Evt const *benchRequesterQueue[BENCH_FLOOD_LEN + 1u];
+static uint32_t benchResponses;
+static uint32_t benchTimeoutResponses; /*of which SPI_TIMEOUT_SIG*/
+
+static SPIManager_Job_t benchJob;
+static uint8_t benchTx[2], benchRx[2];
+static SPIManager_Evnt_t benchReq[BENCH_FLOOD_LEN];
+static const SST_Evt benchCplt = { .sig = SPI_TXRXCOMPLETE_SIG };
+
+static void bench_requester_init(SST_Task *const me, SST_Evt const *const ie) {
+	(void) me;
+	(void) ie;
+}
+
+static void bench_requester_dispatch(SST_Task *const me, SST_Evt const *const e) {
+	(void) me;
+	benchResponses++;
+	if (e->sig == SPI_TIMEOUT_SIG) {
+		benchTimeoutResponses++;
+	}
+}
+
+/*the SPI manager and its requester, shared by the SPI manager benchmarks*/
+static void bench_spi_start(void) {
+	static int started = 0;
+	if (started) {
+		return;
+	}
+	started = 1;
+
+	benchSpi.Instance = &benchSpiRegs;
+	SPIManager_ctor(&benchSpiMgr, &benchSpi);
+	SST_Task_setIRQ(&benchSpiMgr.super, 1u);
+	SST_Task_start(&benchSpiMgr.super, 2u, benchSpiMgrQueue,
+			ARRAY_NELEM(benchSpiMgrQueue), NULL);
+
+	SST_Task_ctor(&benchRequester, &bench_requester_init, &bench_requester_dispatch);
+	SST_Task_setIRQ(&benchRequester, 2u);
+	SST_Task_start(&benchRequester, 1u, benchRequesterQueue,
+			ARRAY_NELEM(benchRequesterQueue), NULL);
+
+	benchJob.pAOrequester = &benchRequester;
+	benchJob.pcsGPIOPort = GPIOA;
+	benchJob.csGPIOPin = GPIO_PIN_0;
+	benchJob.txData = benchTx;
+	benchJob.rxData = benchRx;
+	benchJob.lenData = sizeof(benchTx);
+	benchJob.timeoutCnt_ms = 1000u;
+	for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+		benchReq[i].super.sig = SPI_TXRXREQ_SIG;
+		benchReq[i].pJob = &benchJob;
+	}
+}
+
+/*dispatch overhead per event of the SPI manager against its batch size. Every round a simulated
+ *ISR floods the manager with BENCH_FLOOD_LEN requests (one starts, the rest are queued) and then
+ *with as many completions (each answers the requester and starts the next queued job)*/
+static void bench_spi_flood(void) {
+	static const SST_QCtr batch[] = { 1u, 2u, 4u, 8u, 16u };
+
+	bench_spi_start();
+	for (uint32_t b = 0u; b < ARRAY_NELEM(batch); b++) {
+		SST_Task_setBatch(&benchSpiMgr.super, batch[b]);
+		SST_Task_setBatch(&benchRequester, batch[b]);
+		uint32_t activate0 = SST_Task_getPortStat(&benchSpiMgr.super)->nActivate;
+		benchResponses = 0u;
+
+		uint64_t start_ns = SST_PORT_now_ns();
+		for (uint32_t r = 0u; r < BENCH_FLOOD_ROUNDS; r++) {
+			SST_PORT_isrEntry();
+			for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+				SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchReq[i]);
+			}
+			SST_PORT_isrExit();
+
+			SST_PORT_isrEntry();
+			for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+				SST_Task_post(&benchSpiMgr.super, &benchCplt);
+			}
+			SST_PORT_isrExit();
+		}
+		uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+
+		uint32_t events = BENCH_FLOOD_ROUNDS * BENCH_FLOOD_LEN * 2u;
+		uint32_t activations = SST_Task_getPortStat(&benchSpiMgr.super)->nActivate
+				- activate0;
+		printf("bench=spi_flood batch=%u mgr_events=%lu mgr_activations=%lu responses=%lu ns_per_event=%.2f\n",
+				(unsigned) batch[b], (unsigned long) events,
+				(unsigned long) activations, (unsigned long) benchResponses,
+				(double) elapsed_ns / events);
+	}
+}
+
+/*****************************SPI manager job priorities************************/
+static SPIManager_Job_t benchUrgentJob;
+static SPIManager_Evnt_t benchUrgentReq = { .super.sig = SPI_TXRXREQ_SIG, .pJob = &benchUrgentJob };
+
+/*completes the running job from a simulated ISR, optionally posting one more request with it*/
+static void bench_spi_complete(SPIManager_Evnt_t *pNewReq) {
+	SST_PORT_isrEntry();
+	SST_Task_post(&benchSpiMgr.super, &benchCplt);
+	if (pNewReq != NULL) {
+		SPIManager_post_txrx_Request(&benchSpiMgr.super, pNewReq);
+	}
+	SST_PORT_isrExit();
+}
+
+static void bench_spi_drain(void) {
+	while (benchSpiMgr.MgrState == SPI_MGR_BUSY) {
+		bench_spi_complete(NULL);
+	}
+}
+
+/*jobs started ahead of a time critical job queued behind bulk transfers, with the urgent job at
+ *the bulk priority (FIFO order) and at the top priority. Then the aging bound: a bulk job queued
+ *while urgent jobs keep arriving, it starts after SPIMANAGER_AGING_LIMIT of them*/
+static void bench_spi_prio(void) {
+	static const uint8_t urgentPrio[] = { 0u, SPIMANAGER_NUM_PRIOS - 1u };
+
+	bench_spi_start();
+	benchUrgentJob = benchJob;
+	benchJob.priority = 0u; /*bulk*/
+
+	for (uint32_t p = 0u; p < ARRAY_NELEM(urgentPrio); p++) {
+		benchUrgentJob.priority = urgentPrio[p];
+
+		SST_PORT_isrEntry();
+		for (uint32_t i = 0u; i < BENCH_FLOOD_LEN - 1u; i++) {
+			SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchReq[i]);
+		}
+		SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchUrgentReq);
+		SST_PORT_isrExit();
+
+		uint32_t ahead = 0u;
+		while (benchSpiMgr.pCurrentJob != &benchUrgentJob) {
+			bench_spi_complete(NULL);
+			ahead++;
+		}
+		bench_spi_drain();
+		printf("bench=spi_prio scenario=urgent_behind_bulk bulk_prio=0 urgent_prio=%u bulk_jobs=%u jobs_ahead=%lu\n",
+				(unsigned) urgentPrio[p], (unsigned) (BENCH_FLOOD_LEN - 1u), (unsigned long) ahead);
+	}
+
+	benchUrgentJob.priority = SPIMANAGER_NUM_PRIOS - 1u;
+	uint32_t aged0 = benchSpiMgr.nAged;
+	SST_PORT_isrEntry();
+	SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchUrgentReq); /*starts*/
+	SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchReq[0]); /*bulk, waits*/
+	SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchUrgentReq);
+	SST_PORT_isrExit();
+
+	uint32_t ahead = 0u;
+	while (benchSpiMgr.pCurrentJob != &benchJob) {
+		bench_spi_complete(&benchUrgentReq); /*an urgent job is always waiting*/
+		ahead++;
+	}
+	bench_spi_drain();
+	printf("bench=spi_prio scenario=bulk_under_urgent_stream aging_limit=%u urgent_jobs_ahead=%lu aged_starts=%lu\n",
+			(unsigned) SPIMANAGER_AGING_LIMIT, (unsigned long) ahead,
+			(unsigned long) (benchSpiMgr.nAged - aged0));
+}
+
+/*****************************SPI manager chained jobs************************/
+#define BENCH_CHAIN_LEN (4u) /*jobs per transaction*/
+#define BENCH_CHAIN_ROUNDS (50000u)
+
+static SPIManager_Job_t benchChainJob[BENCH_CHAIN_LEN];
+static SPIManager_Evnt_t benchChainReq[BENCH_CHAIN_LEN];
+
+/*cost per job of BENCH_CHAIN_LEN jobs sent as separate requests (each queued and answered) and
+ *as one chain (started back to back by the manager, answered once)*/
+static void bench_spi_chain(void) {
+	bench_spi_start();
+	for (uint32_t i = 0u; i < BENCH_CHAIN_LEN; i++) {
+		benchChainJob[i] = benchJob;
+		benchChainReq[i].super.sig = SPI_TXRXREQ_SIG;
+		benchChainReq[i].pJob = &benchChainJob[i];
+	}
+
+	for (uint32_t chained = 0u; chained < 2u; chained++) {
+		for (uint32_t i = 0u; i + 1u < BENCH_CHAIN_LEN; i++) {
+			benchChainJob[i].pNext = chained ? &benchChainJob[i + 1u] : NULL;
+		}
+		uint32_t activate0 = SST_Task_getPortStat(&benchSpiMgr.super)->nActivate;
+		benchResponses = 0u;
+
+		uint64_t start_ns = SST_PORT_now_ns();
+		for (uint32_t r = 0u; r < BENCH_CHAIN_ROUNDS; r++) {
+			SST_PORT_isrEntry();
+			for (uint32_t i = 0u; i < (chained ? 1u : BENCH_CHAIN_LEN); i++) {
+				SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchChainReq[i]);
+			}
+			SST_PORT_isrExit();
+			bench_spi_drain();
+		}
+		uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+
+		uint32_t jobs = BENCH_CHAIN_ROUNDS * BENCH_CHAIN_LEN;
+		printf("bench=spi_chain mode=%s jobs=%lu mgr_activations=%lu responses=%lu ns_per_job=%.2f\n",
+				chained ? "chained" : "separate", (unsigned long) jobs,
+				(unsigned long) (SST_Task_getPortStat(&benchSpiMgr.super)->nActivate - activate0),
+				(unsigned long) benchResponses, (double) elapsed_ns / jobs);
+	}
+}
+
+/*****************************SPI completion callback************************/
+#define BENCH_CB_ROUNDS (200000u)
+
+static SST_Task benchSampleTask; /*decodes the samples of the event path*/
+static SST_Evt const *benchSampleQueue[4];
+static SPIManager_Job_t benchSampleJob;
+static SPIManager_Evnt_t benchSampleReq = { .super.sig = SPI_TXRXREQ_SIG, .pJob = &benchSampleJob };
+static uint8_t benchSampleTx[7], benchSampleRx[7];
+static int16_t benchSampleXyz[3];
+static uint64_t benchSampleDone_ns; /*time the sample was decoded*/
+
+static void bench_sample_decode(void) {
+	for (uint32_t i = 0u; i < 3u; i++) {
+		benchSampleXyz[i] = (int16_t) ((benchSampleRx[(2u * i) + 2u] << 8) | benchSampleRx[(2u * i) + 1u]);
+	}
+	benchSampleDone_ns = SST_PORT_now_ns();
+}
+
+static void bench_sample_init(SST_Task *const me, SST_Evt const *const ie) {
+	(void) me;
+	(void) ie;
+}
+
+static void bench_sample_dispatch(SST_Task *const me, SST_Evt const *const e) {
+	(void) me;
+	if (e->sig == SPI_TXRXCOMPLETE_SIG) {
+		bench_sample_decode();
+	}
+}
+
+static void bench_sample_callback(SPIManager_Job_t const *const pJob, SPIManager_JobStatus_t status) {
+	(void) pJob;
+	if (status == SPI_JOB_OK) {
+		bench_sample_decode();
+	}
+}
+
+/*end-to-end latency of a 7 byte sample read, from the SPI complete interrupt to the decoded sample:
+ *through the SPI_TXRXCOMPLETE_SIG response to a requester task (priority 1, below the manager) and
+ *through a completion callback run by the manager*/
+static void bench_spi_callback(void) {
+	bench_spi_start();
+	SST_Task_ctor(&benchSampleTask, &bench_sample_init, &bench_sample_dispatch);
+	SST_Task_setIRQ(&benchSampleTask, 4u);
+	SST_Task_start(&benchSampleTask, 1u, benchSampleQueue, ARRAY_NELEM(benchSampleQueue), NULL);
+
+	benchSampleJob = benchJob;
+	benchSampleJob.pAOrequester = &benchSampleTask;
+	benchSampleJob.txData = benchSampleTx;
+	benchSampleJob.rxData = benchSampleRx;
+	benchSampleJob.lenData = sizeof(benchSampleTx);
+
+	for (uint32_t cb = 0u; cb < 2u; cb++) {
+		benchSampleJob.pfComplete = cb ? &bench_sample_callback : NULL;
+		uint64_t total_ns = 0u;
+		uint64_t max_ns = 0u;
+
+		for (uint32_t r = 0u; r < BENCH_CB_ROUNDS; r++) {
+			SST_PORT_isrEntry();
+			SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchSampleReq);
+			SST_PORT_isrExit();
+			benchSampleRx[1] = (uint8_t) r; /*the bytes clocked in*/
+
+			uint64_t start_ns = SST_PORT_now_ns();
+			bench_spi_complete(NULL);
+			uint64_t lat_ns = benchSampleDone_ns - start_ns;
+			total_ns += lat_ns;
+			max_ns = (lat_ns > max_ns) ? lat_ns : max_ns;
+		}
+		printf("bench=spi_callback path=%s samples=%lu lat_avg_ns=%.1f lat_max_ns=%llu\n",
+				cb ? "callback" : "event", (unsigned long) BENCH_CB_ROUNDS,
+				(double) total_ns / BENCH_CB_ROUNDS, (unsigned long long) max_ns);
+	}
+}
+
+/*****************************SPI interrupt vs DMA transfers************************/
+#define BENCH_DMA_BYTES (2000000u) /*bytes moved per measurement point*/
+#define BENCH_DMA_MAX_LEN (256u)
+
+static DMA_HandleTypeDef benchDmaRx, benchDmaTx;
+static SPIManager_Job_t benchDmaJob;
+static SPIManager_Evnt_t benchDmaReq = { .super.sig = SPI_TXRXREQ_SIG, .pJob = &benchDmaJob };
+static uint8_t benchDmaTxBuff[BENCH_DMA_MAX_LEN], benchDmaRxBuff[BENCH_DMA_MAX_LEN];
+
+/*the bench manager's handle completes to the bench manager, not to the BSP one*/
+static void bench_dma_cplt(SPI_HandleTypeDef *hspi) {
+	(void) hspi;
+	SST_Task_post(&benchSpiMgr.super, &benchCplt);
+}
+
+/*CPU time (ISRs and manager) and interrupts per byte of SPI manager transfers of 2 to 256 bytes,
+ *with an interrupt per byte (HAL *_IT) and with the DMA streams (HAL *_DMA, one interrupt per
+ *transfer). The simulated bus is instant so this is the CPU overhead alone*/
+static void bench_spi_dma(void) {
+	static const uint16_t lens[] = { 2u, 7u, 64u, BENCH_DMA_MAX_LEN };
+
+	bench_spi_start();
+	HAL_SPI_Abort(&benchSpi); /*the other benchmarks complete by hand, leaving it busy*/
+	benchSpi.hostCpltCallback = &bench_dma_cplt;
+	__HAL_LINKDMA(&benchSpi, hdmarx, benchDmaRx);
+	__HAL_LINKDMA(&benchSpi, hdmatx, benchDmaTx);
+
+	benchDmaJob = benchJob;
+	benchDmaJob.txData = benchDmaTxBuff;
+	benchDmaJob.rxData = benchDmaRxBuff;
+
+	for (uint32_t dma = 0u; dma < 2u; dma++) {
+		SPIManager_set_XferMode(&benchSpiMgr, dma ? SPI_MGR_XFER_DMA : SPI_MGR_XFER_IT);
+		for (uint32_t l = 0u; l < ARRAY_NELEM(lens); l++) {
+			uint32_t jobs = BENCH_DMA_BYTES / lens[l];
+			uint32_t irqs = 0u;
+			benchDmaJob.lenData = lens[l];
+
+			uint64_t start_ns = SST_PORT_now_ns();
+			for (uint32_t j = 0u; j < jobs; j++) {
+				SST_PORT_isrEntry();
+				SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchDmaReq);
+				SST_PORT_isrExit();
+				while (benchSpiMgr.MgrState == SPI_MGR_BUSY) {
+					SST_PORT_isrEntry();
+					if ((HAL_host_SPI_IRQHandler(&benchSpi) != 0)
+							|| (HAL_host_DMA_IRQHandler(&benchDmaRx) != 0)
+							|| (HAL_host_DMA_IRQHandler(&benchDmaTx) != 0)) {
+						irqs++;
+					}
+					SST_PORT_isrExit();
+				}
+			}
+			uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+
+			uint32_t bytes = jobs * lens[l];
+			printf("bench=spi_dma mode=%s len=%u jobs=%lu irqs_per_byte=%.3f cpu_ns_per_byte=%.2f\n",
+					dma ? "dma" : "it", (unsigned) lens[l], (unsigned long) jobs,
+					(double) irqs / bytes, (double) elapsed_ns / bytes);
+		}
+	}
+	SPIManager_set_XferMode(&benchSpiMgr, SPI_MGR_XFER_IT);
+	benchSpi.hostCpltCallback = NULL;
+}
+
+/*****************************SPI register engine************************/
+#define BENCH_REG_BYTES (1000000u) /*bytes moved per measurement point*/
+#define BENCH_REG_BYTE_TIME (16u) /*status register reads a byte takes on a slow bus*/
+
+
+/*CPU time, interrupts and SPI register accesses per byte of the register engine, every segment
+ *busy-polled (poll), every one on the RXNE interrupt (irq) and with the default threshold
+ *(SPIMANAGER_POLL_MAX_LEN), against the HAL interrupt mode (it). byte_time is the bus time of a
+ *byte in status register reads, 0 for an instant bus (the CPU overhead alone)*/
+static void bench_spi_reg(void) {
+	static const uint16_t lens[] = { 2u, 7u, 64u };
+	static const struct {
+		char const *name;
+		SPIManager_XferMode_t mode;
+		uint16_t pollMaxLen;
+	} modes[] = {
+		{ "it", SPI_MGR_XFER_IT, 0u },
+		{ "reg_poll", SPI_MGR_XFER_REG, 0xFFFFu },
+		{ "reg_irq", SPI_MGR_XFER_REG, 0u },
+		{ "reg_default", SPI_MGR_XFER_REG, SPIMANAGER_POLL_MAX_LEN },
+	};
+
+	bench_spi_start();
+	HAL_SPI_Abort(&benchSpi); /*the other benchmarks complete by hand, leaving it busy*/
+	benchSpi.hostCpltCallback = &bench_dma_cplt;
+
+	benchDmaJob = benchJob;
+	benchDmaJob.txData = benchDmaTxBuff;
+	benchDmaJob.rxData = benchDmaRxBuff;
+
+	for (uint32_t m = 0u; m < ARRAY_NELEM(modes); m++) {
+		for (uint16_t byteTime = 0u; byteTime <= BENCH_REG_BYTE_TIME; byteTime += BENCH_REG_BYTE_TIME) {
+			if ((modes[m].mode == SPI_MGR_XFER_IT) && (byteTime != 0u)) {
+				continue; /*the HAL model has no bus time*/
+			}
+			if (modes[m].mode == SPI_MGR_XFER_REG) {
+				SPIManager_set_RegEngine(&benchSpiMgr, &benchSpiRegs, modes[m].pollMaxLen);
+			} else {
+				SPIManager_set_XferMode(&benchSpiMgr, modes[m].mode);
+			}
+			benchSpiRegs.hostByteTime = byteTime;
+
+			for (uint32_t l = 0u; l < ARRAY_NELEM(lens); l++) {
+				uint32_t jobs = BENCH_REG_BYTES / lens[l];
+				uint32_t irqs = 0u;
+				uint32_t accesses0 = benchSpiRegs.hostAccesses;
+				benchDmaJob.lenData = lens[l];
+
+				uint64_t start_ns = SST_PORT_now_ns();
+				for (uint32_t j = 0u; j < jobs; j++) {
+					SST_PORT_isrEntry();
+					SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchDmaReq);
+					SST_PORT_isrExit();
+					while (benchSpiMgr.MgrState == SPI_MGR_BUSY) {
+						SST_PORT_isrEntry();
+						if (HAL_host_SPI_IRQHandler(&benchSpi) != 0) {
+							irqs++;
+						} else if (HAL_host_SPI_regIRQ(&benchSpiRegs) != 0) {
+							SPIManager_reg_IRQHandler(&benchSpiMgr);
+							irqs++;
+						}
+						SST_PORT_isrExit();
+					}
+				}
+				uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+
+				uint32_t bytes = jobs * lens[l];
+				printf("bench=spi_reg mode=%s byte_time=%u len=%u jobs=%lu irqs_per_byte=%.3f "
+						"reg_access_per_byte=%.2f cpu_ns_per_byte=%.2f\n", modes[m].name,
+						(unsigned) byteTime, (unsigned) lens[l], (unsigned long) jobs,
+						(double) irqs / bytes,
+						(double) (benchSpiRegs.hostAccesses - accesses0) / bytes,
+						(double) elapsed_ns / bytes);
+			}
+		}
+	}
+	SPIManager_set_XferMode(&benchSpiMgr, SPI_MGR_XFER_IT);
+	benchSpiRegs.hostByteTime = 0u;
+	benchSpi.hostCpltCallback = NULL;
+}
+
+/*****************************SPI per slave bus settings************************/
+#define BENCH_SLAVES_JOBS (200000u)
+#define BENCH_SLAVES_NUM (2u)
+
+/*a fast mode 3 slave and a slow mode 0 one on the same bus*/
+static SPIManager_SlaveCfg_t const benchSlaveCfg[BENCH_SLAVES_NUM] = {
+	{ SPI_BAUDRATEPRESCALER_16, SPI_POLARITY_HIGH, SPI_PHASE_2EDGE, SPI_DATASIZE_8BIT },
+	{ SPI_BAUDRATEPRESCALER_128, SPI_POLARITY_LOW, SPI_PHASE_1EDGE, SPI_DATASIZE_8BIT },
+};
+static uint16_t const benchSlavePin[BENCH_SLAVES_NUM] = { GPIO_PIN_1, GPIO_PIN_2 };
+static SPIManager_Job_t benchSlaveJob[BENCH_SLAVES_NUM];
+static SPIManager_Evnt_t benchSlaveReq[BENCH_SLAVES_NUM];
+static uint32_t benchSlaveWrongCfg; /*bytes a slave saw clocked with other settings than its own*/
+
+/*simulated slave that checks the bus is set up for it while it is selected*/
+static void bench_slave_xfer(void *pSlave, uint8_t const *tx, uint8_t *rx, uint16_t len,
+		int first) {
+	SPIManager_SlaveCfg_t const *cfg = (SPIManager_SlaveCfg_t const*) pSlave;
+	uint32_t mask = SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_DFF;
+	(void) tx;
+	(void) rx;
+	(void) first;
+	if ((benchSpiRegs.CR1 & mask) != (cfg->BaudRatePrescaler | cfg->CLKPolarity | cfg->CLKPhase
+			| cfg->DataSize)) {
+		benchSlaveWrongCfg += len;
+	}
+}
+
+/*bus reconfigurations and CPU time per job for two slaves with different settings, when the jobs
+ *alternate between them (a reconfiguration per job) and when runs of a slave's jobs follow each
+ *other (the settings loaded are kept). The slaves count bytes clocked with the wrong settings*/
+static void bench_spi_slaves(void) {
+	static const uint32_t runs[] = { 1u, 8u, BENCH_SLAVES_JOBS };
+	static int attached = 0;
+
+	bench_spi_start();
+	HAL_SPI_Abort(&benchSpi); /*the other benchmarks complete by hand, leaving it busy*/
+	benchSpi.hostCpltCallback = &bench_dma_cplt;
+	SPIManager_set_XferMode(&benchSpiMgr, SPI_MGR_XFER_IT);
+
+	for (uint32_t i = 0u; i < BENCH_SLAVES_NUM; i++) {
+		benchSlaveJob[i] = benchJob;
+		benchSlaveJob[i].pcsGPIOPort = GPIOB;
+		benchSlaveJob[i].csGPIOPin = benchSlavePin[i];
+		benchSlaveJob[i].pSlaveCfg = &benchSlaveCfg[i];
+		benchSlaveReq[i].super.sig = SPI_TXRXREQ_SIG;
+		benchSlaveReq[i].pJob = &benchSlaveJob[i];
+		if (!attached) {
+			HAL_GPIO_WritePin(GPIOB, benchSlavePin[i], GPIO_PIN_SET);
+			HAL_host_SPI_attach(GPIOB, benchSlavePin[i], &bench_slave_xfer,
+					(void*) &benchSlaveCfg[i]);
+		}
+	}
+	attached = 1;
+
+	for (uint32_t r = 0u; r < ARRAY_NELEM(runs); r++) {
+		uint32_t reconfig0 = benchSpiMgr.nReconfig;
+		benchSlaveWrongCfg = 0u;
+
+		uint64_t start_ns = SST_PORT_now_ns();
+		for (uint32_t j = 0u; j < BENCH_SLAVES_JOBS; j++) {
+			SST_PORT_isrEntry();
+			SPIManager_post_txrx_Request(&benchSpiMgr.super,
+					&benchSlaveReq[(j / runs[r]) % BENCH_SLAVES_NUM]);
+			SST_PORT_isrExit();
+			while (benchSpiMgr.MgrState == SPI_MGR_BUSY) {
+				SST_PORT_isrEntry();
+				(void) HAL_host_SPI_IRQHandler(&benchSpi);
+				SST_PORT_isrExit();
+			}
+		}
+		uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+
+		printf("bench=spi_slaves run=%lu jobs=%lu reconfigs=%lu ns_per_job=%.1f wrong_cfg_bytes=%lu\n",
+				(unsigned long) runs[r], (unsigned long) BENCH_SLAVES_JOBS,
+				(unsigned long) (benchSpiMgr.nReconfig - reconfig0),
+				(double) elapsed_ns / BENCH_SLAVES_JOBS, (unsigned long) benchSlaveWrongCfg);
+	}
+	benchSpi.hostCpltCallback = NULL;
+}
+
+/*****************************SPI pipelined jobs************************/
+#define BENCH_PIPE_MAX_DEPTH (4u)
+#define BENCH_PIPE_JOBS (200000u)
+
+static SST_Task benchPipeTask; /*requester with up to BENCH_PIPE_MAX_DEPTH jobs in flight*/
+static SST_Evt const *benchPipeQueue[BENCH_PIPE_MAX_DEPTH];
+static SPIManager_Job_t benchPipeJob[BENCH_PIPE_MAX_DEPTH];
+static SPIManager_Evnt_t benchPipeReq[BENCH_PIPE_MAX_DEPTH];
+static uint8_t benchPipeRx[BENCH_PIPE_MAX_DEPTH][8];
+static uint32_t benchPipePosted;
+static uint32_t benchPipeDone;
+static uint32_t benchPipeIdle; /*responses that found the bus idle, nothing queued behind them*/
+static uint32_t benchPipeMisorder; /*response not for the oldest job in flight, or seq out of order*/
+static uint32_t benchPipeDepth; /*jobs in flight, the first depth requests cycle*/
+static uint32_t benchPipeNext; /*job expected to finish next (same priority, so in order)*/
+static uint32_t benchPipeLastSeq;
+static uint64_t benchPipeBusTime;
+
+static void bench_pipe_init(SST_Task *const me, SST_Evt const *const ie) {
+	(void) me;
+	(void) ie;
+}
+
+/*match the response to the job in flight, then post the same request again while jobs are left*/
+static void bench_pipe_dispatch(SST_Task *const me, SST_Evt const *const e) {
+	SPIManager_Evnt_t *pResp = (SPIManager_Evnt_t*) e;
+	(void) me;
+
+	if ((pResp->pJob != &benchPipeJob[benchPipeNext])
+			|| ((benchPipeDone != 0u) && (pResp->seq != benchPipeLastSeq + 1u))
+			|| (pResp->status != SPI_JOB_OK)) {
+		benchPipeMisorder++;
+	}
+	benchPipeLastSeq = pResp->seq;
+	benchPipeBusTime += pResp->busTime;
+	benchPipeNext = (benchPipeNext + 1u) % benchPipeDepth;
+	benchPipeDone++;
+	if (benchSpiMgr.MgrState != SPI_MGR_BUSY) {
+		benchPipeIdle++;
+	}
+	if (benchPipePosted < BENCH_PIPE_JOBS) {
+		SPIManager_post_txrx_Request(&benchSpiMgr.super, pResp);
+		benchPipePosted++;
+	}
+}
+
+/*a requester keeping 1 to BENCH_PIPE_MAX_DEPTH read jobs in flight with detailed responses (the
+ *request comes back with its job, sequence number, status and bus time). With one job the bus
+ *goes idle on every response until the requester has posted the next job, with more the next one
+ *is already queued. idle counts the responses that found the bus idle*/
+static void bench_spi_pipeline(void) {
+	static int started = 0;
+
+	bench_spi_start();
+	HAL_SPI_Abort(&benchSpi); /*the other benchmarks complete by hand, leaving it busy*/
+	benchSpi.hostCpltCallback = &bench_dma_cplt;
+	SPIManager_set_XferMode(&benchSpiMgr, SPI_MGR_XFER_IT);
+	if (!started) {
+		started = 1;
+		SST_Task_ctor(&benchPipeTask, &bench_pipe_init, &bench_pipe_dispatch);
+		SST_Task_setIRQ(&benchPipeTask, 5u);
+		SST_Task_start(&benchPipeTask, 1u, benchPipeQueue, ARRAY_NELEM(benchPipeQueue), NULL);
+	}
+	for (uint32_t i = 0u; i < BENCH_PIPE_MAX_DEPTH; i++) {
+		benchPipeJob[i] = benchJob;
+		benchPipeJob[i].pAOrequester = &benchPipeTask;
+		benchPipeJob[i].rxData = benchPipeRx[i];
+		benchPipeJob[i].detailedResp = 1u;
+		benchPipeReq[i].super.sig = SPI_TXRXREQ_SIG;
+		benchPipeReq[i].pJob = &benchPipeJob[i];
+	}
+
+	for (uint32_t depth = 1u; depth <= BENCH_PIPE_MAX_DEPTH; depth++) {
+		benchPipeDepth = depth;
+		benchPipePosted = 0u;
+		benchPipeDone = 0u;
+		benchPipeIdle = 0u;
+		benchPipeMisorder = 0u;
+		benchPipeNext = 0u;
+		benchPipeBusTime = 0u;
+
+		uint64_t start_ns = SST_PORT_now_ns();
+		SST_PORT_isrEntry();
+		for (uint32_t i = 0u; i < depth; i++) {
+			SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchPipeReq[i]);
+			benchPipePosted++;
+		}
+		SST_PORT_isrExit();
+		while (benchPipeDone < BENCH_PIPE_JOBS) {
+			SST_PORT_isrEntry();
+			(void) HAL_host_SPI_IRQHandler(&benchSpi);
+			SST_PORT_isrExit();
+		}
+		uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+
+		printf("bench=spi_pipeline depth=%lu jobs=%lu idle=%lu misorder=%lu ns_per_job=%.1f "
+				"bus_ns_per_job=%.1f\n", (unsigned long) depth, (unsigned long) benchPipeDone,
+				(unsigned long) benchPipeIdle, (unsigned long) benchPipeMisorder,
+				(double) elapsed_ns / benchPipeDone, (double) benchPipeBusTime / benchPipeDone);
+	}
+	benchSpi.hostCpltCallback = NULL;
+}
+
+/*****************************SPI timeout recovery************************/
+#define BENCH_TO_JOBS (30000u) /*jobs per drop rate, posted in bursts of BENCH_FLOOD_LEN*/
+#define BENCH_TO_MAX_TICKS (10000000u) /*give up (stalled queue) after this many simulated ms*/
+
+static SPIManager_Job_t benchToJob;
+
+/*SPI manager recovery from lost complete interrupts (HAL_host_SPI_setDropRate): every burst of
+ *requests has to be answered, OK or after the last retry with SPI_TIMEOUT_SIG, with the chip select
+ *high again. The simulated 1ms tick only runs while the bus waits, so sim_ms is the time lost to
+ *timeouts and backoffs*/
+static void bench_spi_timeout(void) {
+	static const uint32_t dropRates[] = { 0u, 10u, 100u, 300u };
+
+	bench_spi_start();
+	HAL_SPI_Abort(&benchSpi); /*the other benchmarks complete by hand, leaving it busy*/
+	benchSpi.hostCpltCallback = &bench_dma_cplt;
+	SPIManager_set_XferMode(&benchSpiMgr, SPI_MGR_XFER_IT);
+
+	benchToJob = benchJob;
+	benchToJob.timeoutCnt_ms = 2u;
+	benchToJob.retries = 3u;
+	benchToJob.backoff_ms = 1u;
+	for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+		benchReq[i].pJob = &benchToJob;
+	}
+
+	for (uint32_t d = 0u; d < ARRAY_NELEM(dropRates); d++) {
+		uint32_t timeouts0 = benchSpiMgr.nTimeouts;
+		uint32_t retries0 = benchSpiMgr.nRetries;
+		uint32_t abandoned0 = benchSpiMgr.nAbandoned;
+		uint32_t late0 = benchSpiMgr.nLateCplt;
+		uint32_t ticks = 0u;
+		uint32_t posted = 0u;
+
+		HAL_host_SPI_setDropRate(dropRates[d]);
+		benchResponses = 0u;
+		benchTimeoutResponses = 0u;
+		while ((posted < BENCH_TO_JOBS) && (ticks < BENCH_TO_MAX_TICKS)) {
+			SST_PORT_isrEntry();
+			for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+				SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchReq[i]);
+			}
+			SST_PORT_isrExit();
+			posted += BENCH_FLOOD_LEN;
+			/*byte interrupts while a transfer runs, otherwise a tick for the timers*/
+			while ((benchResponses < posted) && (ticks < BENCH_TO_MAX_TICKS)) {
+				SST_PORT_isrEntry();
+				if (HAL_host_SPI_IRQHandler(&benchSpi) == 0) {
+					HAL_IncTick(); /*the backoffs are due by the HAL tick*/
+					SST_TimeEvt_tick();
+					ticks++;
+				}
+				SST_PORT_isrExit();
+			}
+		}
+		HAL_host_SPI_setDropRate(0u);
+
+		printf("bench=spi_timeout drop_permille=%lu jobs=%lu answered=%lu ok=%lu timeouts=%lu "
+				"retries=%lu abandoned=%lu late_cplt=%lu sim_ms=%lu cs_high=%u idle=%u\n",
+				(unsigned long) dropRates[d], (unsigned long) posted,
+				(unsigned long) benchResponses,
+				(unsigned long) (benchResponses - benchTimeoutResponses),
+				(unsigned long) (benchSpiMgr.nTimeouts - timeouts0),
+				(unsigned long) (benchSpiMgr.nRetries - retries0),
+				(unsigned long) (benchSpiMgr.nAbandoned - abandoned0),
+				(unsigned long) (benchSpiMgr.nLateCplt - late0), (unsigned long) ticks,
+				((GPIOA->ODR & GPIO_PIN_0) != 0u) ? 1u : 0u,
+				(benchSpiMgr.MgrState == SPI_MGR_READY) ? 1u : 0u);
+	}
+
+	/*the tick expires a job's 1ms timeout in the same interrupt that completes it, after the
+	 *completion: the timeout is already posted when the job finishes and the next one starts, it
+	 *must not abort that one*/
+	benchToJob.timeoutCnt_ms = 1u;
+	uint32_t timeouts0 = benchSpiMgr.nTimeouts;
+	benchResponses = 0u;
+	benchTimeoutResponses = 0u;
+	SST_PORT_isrEntry();
+	for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+		SPIManager_post_txrx_Request(&benchSpiMgr.super, &benchReq[i]);
+	}
+	SST_PORT_isrExit();
+	while (benchResponses < BENCH_FLOOD_LEN) {
+		SST_PORT_isrEntry();
+		while (HAL_host_SPI_IRQHandler(&benchSpi) != 0) {
+		}
+		HAL_IncTick();
+		SST_TimeEvt_tick();
+		SST_PORT_isrExit();
+	}
+	printf("bench=spi_timeout scenario=cplt_then_timeout jobs=%lu ok=%lu timeouts=%lu idle=%u\n",
+			(unsigned long) BENCH_FLOOD_LEN,
+			(unsigned long) (benchResponses - benchTimeoutResponses),
+			(unsigned long) (benchSpiMgr.nTimeouts - timeouts0),
+			(benchSpiMgr.MgrState == SPI_MGR_READY) ? 1u : 0u);
+
+	for (uint32_t i = 0u; i < BENCH_FLOOD_LEN; i++) {
+		benchReq[i].pJob = &benchJob;
+	}
+	benchSpi.hostCpltCallback = NULL;
+}
+
+/*****************************Lock-free post stress************************/
+#define BENCH_MPSC_MAX_PRODUCERS (8u)
+#define BENCH_MPSC_EVENTS (200000u) /*events per producer*/
+#define BENCH_MPSC_QLEN (32u)
+#define BENCH_MPSC_TIMEOUT_NS (10000000000ull) /*give up (lost events) after 10s*/
+
+typedef struct {
+	SST_Evt super;
+	uint8_t producer;
+	uint32_t seq;
+} BenchMpscEvt_t;
+
+static SST_Task benchConsumer;
+static SST_Evt const *benchConsumerQueue[BENCH_MPSC_QLEN];
+static BenchMpscEvt_t benchMpscEvts[BENCH_MPSC_MAX_PRODUCERS][BENCH_MPSC_QLEN];
+static uint32_t benchMpscCredits; /*free queue entries, keeps the producers from overflowing*/
+static uint32_t benchMpscExpected[BENCH_MPSC_MAX_PRODUCERS];
+static uint32_t benchMpscReceived;
+static uint32_t benchMpscOutOfOrder;
+
+static void bench_consumer_init(SST_Task *const me, SST_Evt const *const ie) {
+	(void) me;
+	(void) ie;
+}
+
+/*every producer's events must arrive exactly once and in the order posted*/
+static void bench_consumer_dispatch(SST_Task *const me, SST_Evt const *const e) {
+	(void) me;
+	BenchMpscEvt_t const *evt = (BenchMpscEvt_t const *) e;
+	if (evt->seq != benchMpscExpected[evt->producer]) {
+		benchMpscOutOfOrder++;
+	}
+	benchMpscExpected[evt->producer] = evt->seq + 1u;
+	benchMpscReceived++;
+	__atomic_fetch_add(&benchMpscCredits, 1u, __ATOMIC_RELEASE);
+}
+
+static void* bench_mpsc_producer(void *arg) {
+	uint8_t producer = (uint8_t) (uintptr_t) arg;
+
+	for (uint32_t i = 0u; i < BENCH_MPSC_EVENTS; i++) {
+		uint32_t credits = __atomic_load_n(&benchMpscCredits, __ATOMIC_ACQUIRE);
+		do {
+			while (credits == 0u) {
+				sched_yield(); /*let the consumer run, also on a single CPU*/
+				credits = __atomic_load_n(&benchMpscCredits, __ATOMIC_ACQUIRE);
+			}
+		} while (!__atomic_compare_exchange_n(&benchMpscCredits, &credits,
+				credits - 1u, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+		/*the event posted BENCH_MPSC_QLEN posts ago has been consumed, or there'd be no credit*/
+		BenchMpscEvt_t *evt = &benchMpscEvts[producer][i % BENCH_MPSC_QLEN];
+		evt->seq = i;
+		SST_Task_post(&benchConsumer, &evt->super);
+	}
+	return NULL;
+}
+
+/*many producer threads hammer the lock-free SST_Task_post of one task queue while the SST
+ *thread consumes, every event must be delivered once and in order per producer*/
+static void bench_post_mpsc(void) {
+	static const uint32_t numProducers[] = { 1u, 2u, 4u, 8u };
+
+	SST_Task_ctor(&benchConsumer, &bench_consumer_init, &bench_consumer_dispatch);
+	SST_Task_setIRQ(&benchConsumer, 3u);
+	SST_Task_start(&benchConsumer, 1u, benchConsumerQueue,
+			ARRAY_NELEM(benchConsumerQueue), NULL);
+
+	for (uint32_t n = 0u; n < ARRAY_NELEM(numProducers); n++) {
+		pthread_t threads[BENCH_MPSC_MAX_PRODUCERS];
+		uint32_t total = numProducers[n] * BENCH_MPSC_EVENTS;
+
+		for (uint32_t p = 0u; p < BENCH_MPSC_MAX_PRODUCERS; p++) {
+			benchMpscExpected[p] = 0u;
+			for (uint32_t i = 0u; i < BENCH_MPSC_QLEN; i++) {
+				benchMpscEvts[p][i].super.sig = 1u;
+				benchMpscEvts[p][i].producer = (uint8_t) p;
+			}
+		}
+		benchMpscReceived = 0u;
+		benchMpscOutOfOrder = 0u;
+		benchMpscCredits = BENCH_MPSC_QLEN;
+
+		uint64_t start_ns = SST_PORT_now_ns();
+		for (uint32_t p = 0u; p < numProducers[n]; p++) {
+			pthread_create(&threads[p], NULL, &bench_mpsc_producer, (void*) (uintptr_t) p);
+		}
+		/*the SST thread only runs the consumer, each simulated ISR exit schedules it*/
+		while ((benchMpscReceived < total)
+				&& ((SST_PORT_now_ns() - start_ns) < BENCH_MPSC_TIMEOUT_NS)) {
+			uint32_t received = benchMpscReceived;
+			SST_PORT_isrEntry();
+			SST_PORT_isrExit();
+			if (received == benchMpscReceived) {
+				sched_yield(); /*nothing posted yet, let the producers run*/
+			}
+		}
+		uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+		if (benchMpscReceived == total) {
+			for (uint32_t p = 0u; p < numProducers[n]; p++) {
+				pthread_join(threads[p], NULL);
+			}
+		}
+
+		printf("bench=post_mpsc producers=%lu events=%lu lost=%lu out_of_order=%lu ns_per_event=%.2f\n",
+				(unsigned long) numProducers[n], (unsigned long) total,
+				(unsigned long) (total - benchMpscReceived),
+				(unsigned long) benchMpscOutOfOrder, (double) elapsed_ns / total);
+		if (benchMpscReceived < total) {
+			fprintf(stderr, "post_mpsc: events lost, the producers are stuck\n");
+			exit(1);
+		}
+	}
+}
+
+/*****************************LIS3DSH snapshot stress************************/
+#define BENCH_SNAP_RUN_NS (500000000ull) /*duration of each stress run*/
+
+typedef enum {
+	BENCH_SNAP_READER_PREEMPTS, /*signal handler reads while the main loop stores*/
+	BENCH_SNAP_WRITER_PREEMPTS, /*signal handler stores while the main loop reads*/
+	BENCH_SNAP_UNPROTECTED, /*as READER_PREEMPTS on a plain sample, shows tears are detected*/
+} BenchSnapMode_t;
+
+static LIS3DSH_Snapshot_t benchSnap;
+static LIS3DSH_Sample_t volatile benchSnapPlain;
+static BenchSnapMode_t volatile benchSnapMode;
+static uint32_t volatile benchSnapWriterSeq;
+static uint32_t volatile benchSnapLastSeq; /*newest sample read so far*/
+static uint32_t volatile benchSnapPreemptions;
+static uint32_t volatile benchSnapReads;
+static uint32_t volatile benchSnapTorn;
+static uint32_t volatile benchSnapStale; /*sample older than one read before*/
+
+/*every field is derived from seq, so a sample mixing two writes doesn't match itself*/
+static LIS3DSH_Sample_t bench_snap_make(uint32_t seq) {
+	LIS3DSH_Sample_t sample = {
+		.Results = { .x_gQ14 = (int16_t) seq, .y_gQ14 = (int16_t) ~seq,
+				.z_gQ14 = (int16_t) (seq * 7u) },
+		.timestamp_ms = seq * 3u,
+		.seq = seq };
+	return sample;
+}
+
+static void bench_snap_check(LIS3DSH_Sample_t const *const pSample) {
+	LIS3DSH_Sample_t expected = bench_snap_make(pSample->seq);
+
+	benchSnapReads++;
+	if ((pSample->Results.x_gQ14 != expected.Results.x_gQ14)
+			|| (pSample->Results.y_gQ14 != expected.Results.y_gQ14)
+			|| (pSample->Results.z_gQ14 != expected.Results.z_gQ14)
+			|| (pSample->timestamp_ms != expected.timestamp_ms)) {
+		benchSnapTorn++;
+		return;
+	}
+	if (pSample->seq < benchSnapLastSeq) {
+		benchSnapStale++;
+	}
+	benchSnapLastSeq = pSample->seq;
+}
+
+static void bench_snap_signal(int sig) {
+	(void) sig;
+	benchSnapPreemptions++;
+	switch (benchSnapMode) {
+	case BENCH_SNAP_READER_PREEMPTS: {
+		LIS3DSH_Sample_t sample = LIS3DSH_snapshot_load(&benchSnap);
+		bench_snap_check(&sample);
+		break;
+	}
+	case BENCH_SNAP_WRITER_PREEMPTS: {
+		LIS3DSH_Sample_t sample = bench_snap_make(++benchSnapWriterSeq);
+		LIS3DSH_snapshot_store(&benchSnap, &sample);
+		break;
+	}
+	case BENCH_SNAP_UNPROTECTED: {
+		LIS3DSH_Sample_t sample = benchSnapPlain;
+		bench_snap_check(&sample);
+		break;
+	}
+	}
+}
+
+static void bench_snap_run(BenchSnapMode_t mode, char const *name) {
+	static const struct itimerval period = {
+		.it_interval = { .tv_sec = 0, .tv_usec = BENCH_ISR_PERIOD_US },
+		.it_value = { .tv_sec = 0, .tv_usec = BENCH_ISR_PERIOD_US } };
+	static const struct itimerval stop = { 0 };
+
+	benchSnap = (LIS3DSH_Snapshot_t) { 0 };
+	benchSnapPlain = bench_snap_make(0u);
+	benchSnap.copy[0] = bench_snap_make(0u);
+	benchSnap.copy[1] = bench_snap_make(0u);
+	benchSnapMode = mode;
+	benchSnapWriterSeq = 0u;
+	benchSnapLastSeq = 0u;
+	benchSnapPreemptions = 0u;
+	benchSnapReads = 0u;
+	benchSnapTorn = 0u;
+	benchSnapStale = 0u;
+
+	setitimer(ITIMER_REAL, &period, NULL);
+	uint64_t start_ns = SST_PORT_now_ns();
+	uint32_t seq = 0u;
+	while ((SST_PORT_now_ns() - start_ns) < BENCH_SNAP_RUN_NS) {
+		for (uint32_t i = 0u; i < 1000u; i++) {
+			if (mode == BENCH_SNAP_WRITER_PREEMPTS) {
+				LIS3DSH_Sample_t sample = LIS3DSH_snapshot_load(&benchSnap);
+				bench_snap_check(&sample);
+			} else if (mode == BENCH_SNAP_READER_PREEMPTS) {
+				LIS3DSH_Sample_t sample = bench_snap_make(++seq);
+				LIS3DSH_snapshot_store(&benchSnap, &sample);
+			} else {
+				/*field by field, as the driver used to update its results*/
+				LIS3DSH_Sample_t sample = bench_snap_make(++seq);
+				benchSnapPlain.Results.x_gQ14 = sample.Results.x_gQ14;
+				benchSnapPlain.Results.y_gQ14 = sample.Results.y_gQ14;
+				benchSnapPlain.Results.z_gQ14 = sample.Results.z_gQ14;
+				benchSnapPlain.timestamp_ms = sample.timestamp_ms;
+				benchSnapPlain.seq = sample.seq;
+			}
+		}
+	}
+	setitimer(ITIMER_REAL, &stop, NULL);
+
+	printf("bench=lis3dsh_snapshot mode=%s preemptions=%lu reads=%lu torn=%lu stale=%lu\n",
+			name, (unsigned long) benchSnapPreemptions, (unsigned long) benchSnapReads,
+			(unsigned long) benchSnapTorn, (unsigned long) benchSnapStale);
+}
+
+/*a SIGALRM interrupts the main loop at arbitrary instructions, like an interrupt on a single
+ *core. Readers of the snapshot must never see a torn or out of date sample whichever side is
+ *preempted, the unprotected run is the control that shows torn samples are caught*/
+static void bench_lis3dsh_snapshot(void) {
+	struct sigaction sa = { 0 };
+	struct sigaction saPrev;
+
+	sa.sa_handler = &bench_snap_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGALRM, &sa, &saPrev);
+
+	bench_snap_run(BENCH_SNAP_READER_PREEMPTS, "reader_preempts");
+	uint32_t torn = benchSnapTorn + benchSnapStale;
+	bench_snap_run(BENCH_SNAP_WRITER_PREEMPTS, "writer_preempts");
+	torn += benchSnapTorn + benchSnapStale;
+	bench_snap_run(BENCH_SNAP_UNPROTECTED, "unprotected");
+
+	sigaction(SIGALRM, &saPrev, NULL);
+	if (torn != 0u) {
+		fprintf(stderr, "lis3dsh_snapshot: torn reads from the snapshot\n");
+		exit(1);
+	}
+}
+
+/*****************************Pool get/put************************/
+#define BENCH_POOL_BLOCK_SIZE (16u)
+#define BENCH_POOL_OPS (2000000u) /*get/put pairs per measurement point*/
+
+static uint64_t benchPoolBuff[(DEVNT_MAX_BLOCKS * BENCH_POOL_BLOCK_SIZE) / sizeof(uint64_t)];
+static void *benchPoolBlocks[DEVNT_MAX_BLOCKS];
+static mpool_t benchMpool;
+static mpool_lf_t benchMpoolLf;
+static devnt_pool_t benchDevnt;
+
+typedef enum {
+	BENCH_POOL_MPOOL, BENCH_POOL_MPOOL_LF, BENCH_POOL_DEVNT
+} BenchPool_t;
+
+/*empties the pool then refills it, so the devnt scans cross every leaf*/
+static uint64_t bench_pool_run(BenchPool_t pool, uint32_t numBlocks) {
+	uint64_t start_ns = SST_PORT_now_ns();
+	for (uint32_t ops = 0u; ops < BENCH_POOL_OPS; ops += numBlocks) {
+		for (uint32_t i = 0u; i < numBlocks; i++) {
+			switch (pool) {
+			case BENCH_POOL_MPOOL:
+				benchPoolBlocks[i] = mpool_get(&benchMpool);
+				break;
+			case BENCH_POOL_MPOOL_LF:
+				benchPoolBlocks[i] = mpool_lf_get(&benchMpoolLf);
+				break;
+			case BENCH_POOL_DEVNT:
+				benchPoolBlocks[i] = devnt_pool_get(&benchDevnt, BENCH_POOL_BLOCK_SIZE);
+				break;
+			}
+		}
+		for (uint32_t i = 0u; i < numBlocks; i++) {
+			switch (pool) {
+			case BENCH_POOL_MPOOL:
+				mpool_put(&benchMpool, (uint8_t*) benchPoolBlocks[i]);
+				break;
+			case BENCH_POOL_MPOOL_LF:
+				mpool_lf_put(&benchMpoolLf, (uint8_t*) benchPoolBlocks[i]);
+				break;
+			case BENCH_POOL_DEVNT:
+				devnt_pool_put(&benchDevnt, (uint8_t*) benchPoolBlocks[i]);
+				break;
+			}
+		}
+	}
+	return SST_PORT_now_ns() - start_ns;
+}
+
+/*get/put cost of the free list pools (mpool and the lock-free mpool_lf) and the bitmap pool
+ *(devnt) by pool size, all on one thread*/
+static void bench_pool_getput(void) {
+	static const uint32_t numBlocks[] = { 32u, 256u, DEVNT_MAX_BLOCKS };
+
+	for (uint32_t n = 0u; n < ARRAY_NELEM(numBlocks); n++) {
+		uint32_t memSize = numBlocks[n] * BENCH_POOL_BLOCK_SIZE;
+		mpool_init(&benchMpool, (uint8_t*) benchPoolBuff, memSize, BENCH_POOL_BLOCK_SIZE);
+		uint64_t mpool_ns = bench_pool_run(BENCH_POOL_MPOOL, numBlocks[n]);
+		mpool_lf_init(&benchMpoolLf, (uint8_t*) benchPoolBuff, memSize, BENCH_POOL_BLOCK_SIZE);
+		uint64_t mpool_lf_ns = bench_pool_run(BENCH_POOL_MPOOL_LF, numBlocks[n]);
+		devnt_pool_init(&benchDevnt, benchPoolBuff, memSize, BENCH_POOL_BLOCK_SIZE);
+		uint64_t devnt_ns = bench_pool_run(BENCH_POOL_DEVNT, numBlocks[n]);
+
+		printf("bench=pool_getput blocks=%lu clz=%s mpool_ns_per_pair=%.2f mpool_lf_ns_per_pair=%.2f devnt_ns_per_pair=%.2f\n",
+				(unsigned long) numBlocks[n], (DEVNT_PORTABLE_CLZ != 0u) ? "portable" : "cmsis",
+				(double) mpool_ns / BENCH_POOL_OPS, (double) mpool_lf_ns / BENCH_POOL_OPS,
+				(double) devnt_ns / BENCH_POOL_OPS);
+	}
+}
+
+/*****************************Pool init (boot time)************************/
+#define BENCH_INIT_BLOCK_SIZE (64u) /*a cache line per block*/
+#define BENCH_INIT_MAX_BLOCKS (32768u)
+#define BENCH_INIT_REPEAT (20u)
+
+static uint64_t benchInitBuff[(BENCH_INIT_MAX_BLOCKS * BENCH_INIT_BLOCK_SIZE) / sizeof(uint64_t)];
+
+/*boot cost of a large pool: the lazy mpool_init is O(1) while mpool_lf_init links every block
+ *up front, also shown is the first pass of gets that hands every block out once*/
+static void bench_pool_init(void) {
+	static const uint32_t numBlocks[] = { 1024u, 8192u, BENCH_INIT_MAX_BLOCKS };
+
+	for (uint32_t n = 0u; n < ARRAY_NELEM(numBlocks); n++) {
+		uint32_t memSize = numBlocks[n] * BENCH_INIT_BLOCK_SIZE;
+		uint64_t mpoolInit_ns = 0u, mpoolDrain_ns = 0u;
+		uint64_t lfInit_ns = 0u, lfDrain_ns = 0u;
+
+		for (uint32_t r = 0u; r < BENCH_INIT_REPEAT; r++) {
+			uint64_t t0 = SST_PORT_now_ns();
+			mpool_init(&benchMpool, (uint8_t*) benchInitBuff, memSize, BENCH_INIT_BLOCK_SIZE);
+			uint64_t t1 = SST_PORT_now_ns();
+			while (mpool_get(&benchMpool) != NULL) {
+			}
+			uint64_t t2 = SST_PORT_now_ns();
+			mpool_lf_init(&benchMpoolLf, (uint8_t*) benchInitBuff, memSize,
+					BENCH_INIT_BLOCK_SIZE);
+			uint64_t t3 = SST_PORT_now_ns();
+			while (mpool_lf_get(&benchMpoolLf) != NULL) {
+			}
+			uint64_t t4 = SST_PORT_now_ns();
+
+			mpoolInit_ns += t1 - t0;
+			mpoolDrain_ns += t2 - t1;
+			lfInit_ns += t3 - t2;
+			lfDrain_ns += t4 - t3;
+		}
+		printf("bench=pool_init blocks=%lu block_size=%u mpool_init_ns=%llu mpool_first_gets_ns=%llu mpool_lf_init_ns=%llu mpool_lf_first_gets_ns=%llu\n",
+				(unsigned long) numBlocks[n], BENCH_INIT_BLOCK_SIZE,
+				(unsigned long long) (mpoolInit_ns / BENCH_INIT_REPEAT),
+				(unsigned long long) (mpoolDrain_ns / BENCH_INIT_REPEAT),
+				(unsigned long long) (lfInit_ns / BENCH_INIT_REPEAT),
+				(unsigned long long) (lfDrain_ns / BENCH_INIT_REPEAT));
+	}
+}
+
+/*****************************Magazine cache************************/
+#define BENCH_MAG_BLOCKS (64u)
+#define BENCH_MAG_DEPTH (4u) /*blocks a task holds at once*/
+#define BENCH_MAG_ROUNDS (500000u)
+
+static mpool_cache_t benchMagCache;
+
+/*runs a pattern of gets and puts, either straight on the pool or through the magazines.
+ *same_level: one priority level gets and puts BENCH_MAG_DEPTH blocks (LIFO).
+ *cross_level: priority 1 gets the blocks and priority 2 puts them, as for an event posted from a
+ *producer task to a consumer task. The levels are given explicitly, the bench is one context*/
+static uint64_t bench_mag_run(int cached, int crossLevel) {
+	void *blocks[BENCH_MAG_DEPTH];
+	uint8_t putPrio = crossLevel ? 2u : 1u;
+
+	uint64_t start_ns = SST_PORT_now_ns();
+	for (uint32_t r = 0u; r < BENCH_MAG_ROUNDS; r++) {
+		for (uint32_t i = 0u; i < BENCH_MAG_DEPTH; i++) {
+			blocks[i] = cached ? mpool_cache_get_at(&benchMagCache, 1u) : mpool_get(&benchMpool);
+		}
+		for (uint32_t i = BENCH_MAG_DEPTH; i > 0u; i--) {
+			if (cached) {
+				mpool_cache_put_at(&benchMagCache, (uint8_t*) blocks[i - 1u], putPrio);
+			} else {
+				mpool_put(&benchMpool, (uint8_t*) blocks[i - 1u]);
+			}
+		}
+	}
+	return SST_PORT_now_ns() - start_ns;
+}
+
+/*pool critical sections and cost per get or put with and without the per priority magazines,
+ *every plain mpool get and put locks the pool once, the magazines only to move a batch*/
+static void bench_mpool_cache(void) {
+	static char const *const patterns[] = { "same_level", "cross_level" };
+	uint32_t ops = BENCH_MAG_ROUNDS * BENCH_MAG_DEPTH * 2u;
+
+	for (uint32_t p = 0u; p < ARRAY_NELEM(patterns); p++) {
+		mpool_init(&benchMpool, (uint8_t*) benchPoolBuff, BENCH_MAG_BLOCKS * BENCH_POOL_BLOCK_SIZE,
+				BENCH_POOL_BLOCK_SIZE);
+		uint64_t mpool_ns = bench_mag_run(0, (int) p);
+
+		mpool_cache_init(&benchMagCache, &benchMpool);
+		uint64_t cache_ns = bench_mag_run(1, (int) p);
+		uint32_t cacheCrit = 0u;
+		for (uint32_t l = 0u; l < MPOOL_MAG_LEVELS; l++) {
+			cacheCrit += benchMagCache.mag[l].nRefill + benchMagCache.mag[l].nFlush;
+		}
+
+		printf("bench=mpool_cache pattern=%s ops=%lu mag_size=%u mpool_crit=%lu cache_crit=%lu crit_saved_pct=%.1f mpool_ns_per_op=%.2f cache_ns_per_op=%.2f\n",
+				patterns[p], (unsigned long) ops, MPOOL_MAG_SIZE, (unsigned long) ops,
+				(unsigned long) cacheCrit, 100.0 * (double) (ops - cacheCrit) / ops,
+				(double) mpool_ns / ops, (double) cache_ns / ops);
+	}
+}
+
+/*****************************Allocator patterns************************/
+/*the allocator microbenchmarks of poolbench.c, the same code runs on the target (BSP_POOL_BENCH)*/
+#if (SST_TASK_STATS != 0)
+static void bench_alloc(void) {
+	pool_bench_run_all();
+}
+#endif
+
+/*****************************Lock-free pool torture************************/
+#define BENCH_LF_MAX_THREADS (8u)
+#define BENCH_LF_BLOCKS (8u) /*fewer blocks than threads x 2, so the pool runs empty*/
+#define BENCH_LF_BLOCK_WORDS (4u)
+#define BENCH_LF_PAIRS (200000u) /*get/put pairs per thread*/
+
+static uint32_t benchLfBuff[BENCH_LF_BLOCKS * BENCH_LF_BLOCK_WORDS];
+static mpool_lf_t benchLf;
+static uint32_t benchLfEmpty; /*gets that found the pool empty*/
+static uint32_t benchLfCorrupt; /*blocks changed by another thread while owned*/
+static uint32_t *benchLfIsrBlock; /*block the "ISR" keeps until its next run*/
+static uint32_t benchLfIsrRuns;
+
+static void bench_lf_stamp(uint32_t *block, uint32_t stamp) {
+	for (uint32_t w = 0u; w < BENCH_LF_BLOCK_WORDS; w++) {
+		__atomic_store_n(&block[w], stamp, __ATOMIC_RELAXED);
+	}
+}
+
+static int bench_lf_check(uint32_t *block, uint32_t stamp) {
+	for (uint32_t w = 0u; w < BENCH_LF_BLOCK_WORDS; w++) {
+		if (__atomic_load_n(&block[w], __ATOMIC_RELAXED) != stamp) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*SIGALRM handler, preempts the threads anywhere like an ISR does. Takes two blocks and puts the
+ *first back, so a get it preempted sees the same head again with the second block gone (ABA)*/
+static void bench_lf_isr(int sig) {
+	(void) sig;
+	uint32_t run = __atomic_add_fetch(&benchLfIsrRuns, 1u, __ATOMIC_RELAXED);
+	uint32_t stamp = 0xFF000000u | (run & 0xFFFFFFu);
+	uint32_t *kept = __atomic_exchange_n(&benchLfIsrBlock, NULL, __ATOMIC_ACQ_REL);
+
+	if (kept != NULL) {
+		if (!bench_lf_check(kept, __atomic_load_n(&kept[0], __ATOMIC_RELAXED))
+				|| ((kept[0] & 0xFF000000u) != 0xFF000000u)) {
+			__atomic_fetch_add(&benchLfCorrupt, 1u, __ATOMIC_RELAXED);
+		}
+		mpool_lf_put(&benchLf, (uint8_t*) kept);
+	}
+	uint32_t *x = (uint32_t*) mpool_lf_get(&benchLf);
+	uint32_t *y = (uint32_t*) mpool_lf_get(&benchLf);
+	if (x != NULL) {
+		bench_lf_stamp(x, stamp);
+		mpool_lf_put(&benchLf, (uint8_t*) x);
+	}
+	if (y != NULL) {
+		bench_lf_stamp(y, stamp);
+		kept = __atomic_exchange_n(&benchLfIsrBlock, y, __ATOMIC_ACQ_REL);
+		if (kept != NULL) { /*another thread's ISR kept one meanwhile*/
+			mpool_lf_put(&benchLf, (uint8_t*) kept);
+		}
+	}
+}
+
+/*gets two blocks, without holding the first while waiting for the second (that could deadlock
+ *all the threads with one block each)*/
+static void bench_lf_get2(uint32_t *blocks[2]) {
+	for (;;) {
+		blocks[0] = (uint32_t*) mpool_lf_get(&benchLf);
+		blocks[1] = (blocks[0] != NULL) ? (uint32_t*) mpool_lf_get(&benchLf) : NULL;
+		if (blocks[1] != NULL) {
+			return;
+		}
+		if (blocks[0] != NULL) {
+			mpool_lf_put(&benchLf, (uint8_t*) blocks[0]);
+		}
+		__atomic_fetch_add(&benchLfEmpty, 1u, __ATOMIC_RELAXED);
+		sched_yield();
+	}
+}
+
+/*each thread owns up to two blocks at a time, stamps them and checks nobody else got them*/
+static void* bench_lf_thread(void *arg) {
+	uint32_t thread = (uint32_t) (uintptr_t) arg;
+
+	for (uint32_t i = 0u; i < BENCH_LF_PAIRS; i++) {
+		uint32_t *blocks[2];
+		uint32_t stamp = (thread << 24) | (i & 0xFFFFFFu);
+
+		bench_lf_get2(blocks);
+		bench_lf_stamp(blocks[0], stamp);
+		bench_lf_stamp(blocks[1], stamp + 1u);
+		if ((i % 16u) == 0u) {
+			sched_yield(); /*hold the blocks across a reschedule now and then*/
+		}
+		for (uint32_t b = 2u; b > 0u; b--) {
+			if (!bench_lf_check(blocks[b - 1u], stamp + b - 1u)) {
+				__atomic_fetch_add(&benchLfCorrupt, 1u, __ATOMIC_RELAXED);
+			}
+			mpool_lf_put(&benchLf, (uint8_t*) blocks[b - 1u]);
+		}
+	}
+	return NULL;
+}
+
+/*threads get and put concurrently through the lock-free pool while a fast SIGALRM preempts them
+ *with more gets and puts, no block may ever be handed out twice and all of them must be back on
+ *the free list at the end*/
+static void bench_mpool_lf(void) {
+	static const uint32_t numThreads[] = { 1u, 2u, 4u, 8u };
+	static const struct itimerval period = {
+		.it_interval = { .tv_sec = 0, .tv_usec = BENCH_ISR_PERIOD_US },
+		.it_value = { .tv_sec = 0, .tv_usec = BENCH_ISR_PERIOD_US } };
+	static const struct itimerval stop = { 0 };
+	struct sigaction sa = { 0 };
+	struct sigaction saPrev;
+
+	sa.sa_handler = &bench_lf_isr;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &sa, &saPrev);
+
+	for (uint32_t n = 0u; n < ARRAY_NELEM(numThreads); n++) {
+		pthread_t threads[BENCH_LF_MAX_THREADS];
+		uint32_t pairs = numThreads[n] * BENCH_LF_PAIRS * 2u;
+
+		mpool_lf_init(&benchLf, (uint8_t*) benchLfBuff, sizeof(benchLfBuff),
+				BENCH_LF_BLOCK_WORDS * sizeof(uint32_t));
+		benchLfEmpty = 0u;
+		benchLfCorrupt = 0u;
+		benchLfIsrBlock = NULL;
+		benchLfIsrRuns = 0u;
+
+		uint64_t start_ns = SST_PORT_now_ns();
+		setitimer(ITIMER_REAL, &period, NULL);
+		for (uint32_t t = 0u; t < numThreads[n]; t++) {
+			pthread_create(&threads[t], NULL, &bench_lf_thread, (void*) (uintptr_t) t);
+		}
+		for (uint32_t t = 0u; t < numThreads[n]; t++) {
+			pthread_join(threads[t], NULL);
+		}
+		setitimer(ITIMER_REAL, &stop, NULL);
+		uint64_t elapsed_ns = SST_PORT_now_ns() - start_ns;
+		if (benchLfIsrBlock != NULL) {
+			mpool_lf_put(&benchLf, (uint8_t*) benchLfIsrBlock);
+		}
+
+		/*walk the free list, every block must be on it exactly once*/
+		uint32_t onList = 0u;
+		uint32_t seen = 0u;
+		for (uint32_t idx = benchLf.head & MPOOL_LF_IDX_MSK;
+				(idx != 0u) && (onList <= BENCH_LF_BLOCKS);
+				idx = benchLfBuff[(idx - 1u) * BENCH_LF_BLOCK_WORDS]) {
+			if ((seen & (1u << (idx - 1u))) == 0u) {
+				seen |= 1u << (idx - 1u);
+				onList++;
+			} else {
+				onList = BENCH_LF_BLOCKS + 1u; /*loop in the list*/
+			}
+		}
+		uint32_t lost = (onList == BENCH_LF_BLOCKS) ? 0u : 1u;
+
+		printf("bench=mpool_lf threads=%lu isr_runs=%lu pairs=%lu ns_per_pair=%.2f empty=%lu corrupt=%lu free=%lu/%lu list_ok=%u\n",
+				(unsigned long) numThreads[n], (unsigned long) benchLfIsrRuns, (unsigned long) pairs,
+				(double) elapsed_ns / pairs, (unsigned long) benchLfEmpty,
+				(unsigned long) benchLfCorrupt, (unsigned long) benchLf.free,
+				(unsigned long) BENCH_LF_BLOCKS, (unsigned) (lost == 0u));
+		if ((benchLfCorrupt != 0u) || (lost != 0u) || (benchLf.free != BENCH_LF_BLOCKS)) {
+			fprintf(stderr, "mpool_lf: block handed out twice or lost\n");
+			exit(1);
+		}
+	}
+	sigaction(SIGALRM, &saPrev, NULL);
+}
+
+/*****************************Benchmark table************************/
+typedef struct {
+	char const *name;
+	BSP_host_bench_t run;
+} BSP_host_bench_entry_t;
+
+static const BSP_host_bench_entry_t benchmarks[] = {
+	{ "timeevt_tick", &bench_timeevt_tick },
+	{ "spi_flood", &bench_spi_flood },
+	{ "spi_prio", &bench_spi_prio },
+	{ "spi_chain", &bench_spi_chain },
+	{ "spi_callback", &bench_spi_callback },
+	{ "spi_dma", &bench_spi_dma },
+	{ "spi_reg", &bench_spi_reg },
+	{ "spi_slaves", &bench_spi_slaves },
+	{ "spi_pipeline", &bench_spi_pipeline },
+	{ "spi_timeout", &bench_spi_timeout },
+	{ "post_mpsc", &bench_post_mpsc },
+	{ "lis3dsh_snapshot", &bench_lis3dsh_snapshot },
+	{ "pool_getput", &bench_pool_getput },
+	{ "mpool_lf", &bench_mpool_lf },
+	{ "pool_init", &bench_pool_init },
+	{ "mpool_cache", &bench_mpool_cache },
+#if (SST_TASK_STATS != 0) /*poolbench.c times with the stats cycle counter*/
+	{ "alloc", &bench_alloc },
+#endif
+};
+
+int BSP_host_bench(char const *name) {
+	int found = 0;
+
+	SST_init(); /*benchmarks run outside of the application, on a clean kernel*/
+	for (uint32_t i = 0u; i < ARRAY_NELEM(benchmarks); i++) {
+		if ((strcmp(name, "all") == 0) || (strcmp(name, benchmarks[i].name) == 0)) {
+			benchmarks[i].run();
+			found = 1;
+		}
+	}
+	if (!found) {
+		fprintf(stderr, "unknown benchmark: %s\n", name);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,480 @@
+/*
+ * bsp_host.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Host (Linux) board support package. Configures the same tasks as bsp.c on top of the
+ *      POSIX SST port and replaces the DISC1 hardware with simulations:
+ *      - the SysTick is a simulated 1ms ISR raised from SST_onIdle (time runs as fast as the
+ *        host can execute the application, not in real time). In tickless mode the simulated
+ *        tick source is programmed to the earliest time event expiry instead, like the
+ *        SysTick reprogramming of the Cortex-M port,
+ *      - the SPI1 transfer complete interrupt is raised from SST_onIdle as soon as the
+ *        manager starts a transfer (or the SPI1 register model RXNE interrupt for the register
+ *        engine),
+ *      - the LIS3DSH is a register model attached to the simulated SPI bus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bsp.h"
+#include "bsp_host.h"
+#include "main.h"
+#include "sst.h"
+#include "blinky.h"
+#include "spi_manager.h"
+#include "mempool.h"
+
+/*****************************Simulation state***************************************/
+static uint32_t simTime_ms; /*simulated time since start*/
+static uint32_t simRunTime_ms = 10000u;
+static uint64_t wallStart_ns;
+static uint8_t simTickless; /*simulated tick source fires only at the next time event*/
+static uint32_t simWakeups; /*tick source interrupts taken*/
+static uint32_t simSkipped; /*ticks slept through, taken by the next simulated SysTick*/
+static uint8_t simSpiDma; /*SPI manager transfers on the simulated DMA streams*/
+static uint8_t simSpiReg; /*SPI manager register engine on the SPI1 register model*/
+static uint32_t simSpiIrqs; /*SPI and DMA interrupts taken*/
+
+static uint16_t LEDDuty[4]; /*blue, red, orange, green*/
+
+/*****************************Event pools************************/
+/*event pools are size classes, SST_Evt_new takes the smallest one that fits and has a free block.
+ *Tune the lengths with the per pool statistics (SST_Evt_getPoolStat)*/
+#define EVT_POOL_CLASSES (3u) /*pools added in BSP_init_event_pools*/
+#define EVT_POOL_LEN (8u) /*dynamic events in flight at any time*/
+
+/*block size rounded up to whole pointers, so every block can hold the free list link*/
+#define EVT_BLOCK_SIZE(evt_) (((sizeof(evt_) + sizeof(void*) - 1u) \
+		/ sizeof(void*)) * sizeof(void*))
+
+/*signal only events (bare SST_Evt), so they don't take a request sized block*/
+#define SMALL_POOL_LEN (4u)
+#define SMALL_BLOCK_SIZE EVT_BLOCK_SIZE(SST_Evt)
+
+/*accelerometer samples in flight, each one is shared by all its subscribers*/
+#define SAMPLE_POOL_LEN (4u)
+#define SAMPLE_BLOCK_SIZE EVT_BLOCK_SIZE(LIS3DSH_SampleEvnt_t)
+
+static mpool_t smallPool; /*pool of signal only events*/
+static uint64_t smallPoolBuff[(SMALL_POOL_LEN * SMALL_BLOCK_SIZE)
+		/ sizeof(uint64_t)]; /*pointer aligned storage*/
+
+static mpool_t samplePool; /*pool of published LIS3DSH sample events*/
+static uint64_t samplePoolBuff[(SAMPLE_POOL_LEN * SAMPLE_BLOCK_SIZE)
+		/ sizeof(uint64_t)]; /*pointer aligned storage*/
+
+static mpool_t evtPool; /*pool of dynamic SPI manager request events*/
+static uint64_t evtPoolBuff[(EVT_POOL_LEN * sizeof(SPIManager_JobEvnt_t))
+		/ sizeof(uint64_t)]; /*pointer aligned storage*/
+
+static void BSP_init_event_pools(void) {
+	mpool_init(&evtPool, (uint8_t*) evtPoolBuff, sizeof(evtPoolBuff),
+			sizeof(SPIManager_JobEvnt_t));
+
+	mpool_init(&samplePool, (uint8_t*) samplePoolBuff, sizeof(samplePoolBuff),
+			SAMPLE_BLOCK_SIZE);
+
+	mpool_init(&smallPool, (uint8_t*) smallPoolBuff, sizeof(smallPoolBuff),
+			SMALL_BLOCK_SIZE);
+
+	/*pools have to be added in ascending block size*/
+	SST_Evt_addPool(&smallPool, SMALL_BLOCK_SIZE, &mpool_evt_get,
+			&mpool_evt_put);
+	SST_Evt_addPool(&samplePool, SAMPLE_BLOCK_SIZE, &mpool_evt_get,
+			&mpool_evt_put);
+	SST_Evt_addPool(&evtPool, sizeof(SPIManager_JobEvnt_t), &mpool_evt_get,
+			&mpool_evt_put);
+}
+
+/*****************************Publish-subscribe************************/
+static SST_SubscrList subscrSto[PRJ_SIGS_MAX]; /*subscribers of each project signal*/
+
+/************************SPI task config**********************************/
+
+SPI_HandleTypeDef hspi1; /*simulated spi device handle*/
+static DMA_HandleTypeDef hdma_spi1_rx; /*simulated DMA2 stream 0 / stream 3 of SPI1*/
+static DMA_HandleTypeDef hdma_spi1_tx;
+
+#define SPIMANAGER_IRQn (80u)
+#define SPIMANAGER_TASK_PRIORITY ((SST_TaskPrio)2u)
+#define SPIHANDLER_MSG_QUEUELEN (10u)
+
+static SPIManager_Task_t SpiMgrInstance;
+static SST_Evt const *spiMsgQueue[SPIHANDLER_MSG_QUEUELEN];
+static SST_Task *const AO_SpiMgr = &(SpiMgrInstance.super); /*Scheduler task pointer*/
+
+static void BSP_init_SPIManager_Task(void) {
+	/*as MX_SPI1_Init on the DISC1, the default bus settings*/
+	hspi1.Instance = SPI1;
+	hspi1.Init.DataSize = SPI_DATASIZE_8BIT;
+	hspi1.Init.CLKPolarity = SPI_POLARITY_HIGH;
+	hspi1.Init.CLKPhase = SPI_PHASE_2EDGE;
+	hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_32;
+	SPIManager_ctor(&SpiMgrInstance, &hspi1);
+	if (simSpiReg != 0u) {
+		SPIManager_set_RegEngine(&SpiMgrInstance, hspi1.Instance, SPIMANAGER_POLL_MAX_LEN);
+	} else if (simSpiDma != 0u) {
+		__HAL_LINKDMA(&hspi1, hdmarx, hdma_spi1_rx);
+		__HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+		SPIManager_set_XferMode(&SpiMgrInstance, SPI_MGR_XFER_DMA);
+	}
+
+	SST_Task_setIRQ(AO_SpiMgr, SPIMANAGER_IRQn);
+
+	SST_Task_start(AO_SpiMgr, SPIMANAGER_TASK_PRIORITY, spiMsgQueue,
+	SPIHANDLER_MSG_QUEUELEN, 0);
+}
+
+/*immutable txrx complete event signal*/
+static const SST_Evt TxxRxCompleteEventSignal = { .sig = SPI_TXRXCOMPLETE_SIG };
+static SST_Evt const *const pTxRxCompleteEventSignal = &TxxRxCompleteEventSignal;
+
+/*SPI device needs to post calback events to the SPI managers*/
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == &hspi1) {
+		SST_Task_post(AO_SpiMgr, pTxRxCompleteEventSignal);
+	}
+}
+
+/*transmit only segments of scatter-gather jobs*/
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	HAL_SPI_TxRxCpltCallback(hspi);
+}
+
+/*receive only segments (a full duplex master completes these as TxRx on the target)*/
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+	HAL_SPI_TxRxCpltCallback(hspi);
+}
+
+/*****************************LIS3DSH Task Config************************/
+#define LIS3DSH_IRQn (78u) /*DCMI_IRQn on the STM32F407*/
+#define LIS3DSH_TASK_PRIORITY ((SST_TaskPrio)1u)
+#define LIS3DSH_MSG_QUEUELEN (2u)
+
+static LIS3DSH_task_t LIS3DSHInstance;
+
+static SST_Evt const *LIS3DSHMsgQueue[LIS3DSH_MSG_QUEUELEN];
+static SST_Task *const AO_LIS3DSH = &(LIS3DSHInstance.super); /*Scheduler task pointer*/
+
+static void BSP_init_LIS3DSH_Task(void) {
+
+	LIS3DSH_ctor(&LIS3DSHInstance, AO_SpiMgr,
+	CS_I2C_SPI_GPIO_Port, CS_I2C_SPI_Pin);
+
+	SST_Task_setIRQ(AO_LIS3DSH, LIS3DSH_IRQn);
+
+	SST_Task_start(AO_LIS3DSH, LIS3DSH_TASK_PRIORITY, LIS3DSHMsgQueue,
+	LIS3DSH_MSG_QUEUELEN, 0);
+}
+
+LIS3DSH_Sample_t LIS3DSH_read(void)
+{
+	/*coherent snapshot of the latest sample, safe from any priority without locking*/
+	return LIS3DSH_get_sample(&LIS3DSHInstance);
+}
+
+/*****************************Blinky Task Config************************/
+
+#define BLINKY_IRQn (79u)
+#define BLINKY_TASK_PRIORITY ((SST_TaskPrio)1u)
+
+static BlinkyTask_T BlinkyInstance;
+static SST_Task *const AO_Blink = &(BlinkyInstance.super); /*Scheduler task pointer*/
+
+#define BLINKY_MSG_QUEUELEN (10u)
+static SST_Evt const *blinkyMsgQueue[BLINKY_MSG_QUEUELEN];
+
+static void BSP_init_blinky_task(void) {
+	Blinky_ctor(&BlinkyInstance);
+
+	SST_Task_setIRQ(AO_Blink, BLINKY_IRQn);
+
+	SST_Task_start(AO_Blink, BLINKY_TASK_PRIORITY, blinkyMsgQueue,
+			BLINKY_MSG_QUEUELEN, 0); /*no initial event*/
+}
+
+/*****************************Simulated LIS3DSH************************/
+#define LIS3DSH_SIM_READ (0x80u)
+#define LIS3DSH_SIM_ADDR_MSK (0x3Fu)
+#define LIS3DSH_SIM_WHO_AM_I (0x3Fu)
+#define LIS3DSH_SIM_OUT_X_L (0x28u)
+#define LIS3DSH_SIM_TILT_PERIOD_MS (2000u)
+
+typedef struct {
+	uint8_t regs[LIS3DSH_SIM_ADDR_MSK + 1u];
+	uint8_t addr; /*register of the next byte of the frame*/
+	uint8_t read; /*frame is a read*/
+} LIS3DSH_Sim_t;
+
+static LIS3DSH_Sim_t LIS3DSHSim = { .regs = { [0x0F] = LIS3DSH_SIM_WHO_AM_I } };
+
+/*register access with address auto increment, the first byte of a frame (chip select low) is the
+ *(read bit | address), later transfers in the same frame carry on from the next register*/
+static void LIS3DSH_sim_xfer(void *pSlave, uint8_t const *tx, uint8_t *rx,
+		uint16_t len, int first) {
+	LIS3DSH_Sim_t *me = (LIS3DSH_Sim_t*) pSlave;
+	uint32_t i = 0u;
+
+	if (first) {
+		me->addr = tx[0] & LIS3DSH_SIM_ADDR_MSK;
+		me->read = ((tx[0] & LIS3DSH_SIM_READ) != 0u) ? 1u : 0u;
+		i = 1u;
+	}
+	for (; i < len; i++) {
+		if (me->read) {
+			rx[i] = me->regs[me->addr];
+		} else {
+			me->regs[me->addr] = tx[i];
+		}
+		me->addr = (me->addr + 1u) & LIS3DSH_SIM_ADDR_MSK;
+	}
+}
+
+/*slowly tilt the board around the z axis (triangle waves in Q14 g) */
+static void LIS3DSH_sim_sample(LIS3DSH_Sim_t *me, uint32_t t_ms) {
+	uint32_t phase = t_ms % LIS3DSH_SIM_TILT_PERIOD_MS;
+	uint32_t half = LIS3DSH_SIM_TILT_PERIOD_MS / 2u;
+	int32_t x = (int32_t) ((phase < half) ? phase : (LIS3DSH_SIM_TILT_PERIOD_MS - phase));
+	x = ((x * 16384) / (int32_t) half) - 8192; /*+-0.5g*/
+	int32_t y = -x;
+	int32_t z = 16384; /*1g*/
+	int16_t out[3] = { (int16_t) x, (int16_t) y, (int16_t) z };
+
+	for (uint32_t i = 0u; i < 3u; i++) {
+		me->regs[LIS3DSH_SIM_OUT_X_L + (2u * i)] = (uint8_t) ((uint16_t) out[i] & 0xFFu);
+		me->regs[LIS3DSH_SIM_OUT_X_L + (2u * i) + 1u] = (uint8_t) ((uint16_t) out[i] >> 8);
+	}
+}
+
+/*****************************BSP************************/
+
+void BSP_init(void) {
+	HAL_GPIO_WritePin(CS_I2C_SPI_GPIO_Port, CS_I2C_SPI_Pin, GPIO_PIN_SET); /*set chip select high initially*/
+	HAL_host_SPI_attach(CS_I2C_SPI_GPIO_Port, CS_I2C_SPI_Pin, &LIS3DSH_sim_xfer,
+			&LIS3DSHSim);
+	LIS3DSH_sim_sample(&LIS3DSHSim, 0u);
+
+	BSP_init_event_pools(); /*before the tasks, which may allocate events on start*/
+	SST_PubSub_init(subscrSto, PRJ_SIGS_MAX); /*before the tasks, which may subscribe on start*/
+	BSP_init_SPIManager_Task();
+	BSP_init_blinky_task();
+	BSP_init_LIS3DSH_Task();
+}
+
+void BSP_host_setRunTime(uint32_t run_ms) {
+	simRunTime_ms = run_ms;
+}
+
+void BSP_host_setTickless(uint8_t enable) {
+	simTickless = enable;
+}
+
+void BSP_host_setSpiDma(uint8_t enable) {
+	simSpiDma = enable;
+}
+
+void BSP_host_setSpiReg(uint8_t enable) {
+	simSpiReg = enable;
+}
+
+void BSP_host_setSpiDropRate(uint32_t perMille) {
+	HAL_host_SPI_setDropRate(perMille);
+}
+
+static void BSP_host_report_task(char const *name, SST_Task const *task) {
+	SST_PortStat const *stat = SST_Task_getPortStat(task);
+	printf("task=%s dispatched=%lu activations=%lu lat_avg_ns=%llu lat_max_ns=%llu\n",
+			name, (unsigned long) stat->nDispatch, (unsigned long) stat->nActivate,
+			(unsigned long long) ((stat->nDispatch != 0u) ?
+					(stat->latTotal_ns / stat->nDispatch) : 0u),
+			(unsigned long long) stat->latMax_ns);
+#if (SST_TASK_STATS != 0)
+	SST_TaskStat const *run = SST_Task_getStat(task);
+	printf("task=%s queue_max_used=%u run_min_ns=%lu run_avg_ns=%llu run_max_ns=%lu\n",
+			name, (unsigned) run->maxUsed,
+			(unsigned long) ((run->nDispatch != 0u) ? run->runMin : 0u),
+			(unsigned long long) ((run->nDispatch != 0u) ?
+					(run->runTotal / run->nDispatch) : 0u),
+			(unsigned long) run->runMax);
+#endif
+}
+
+#if (POOL_STATS != 0)
+static char const* BSP_host_ctx_name(uint16_t ctx) {
+	switch (ctx) {
+	case 16u + SPIMANAGER_IRQn:
+		return "spi_mgr";
+	case 16u + LIS3DSH_IRQn:
+		return "LIS3DSH";
+	case 16u + BLINKY_IRQn:
+		return "blinky";
+	case SST_PORT_ISR_CTX:
+		return "isr";
+	default:
+		return "main";
+	}
+}
+
+static void BSP_host_report_pool(char const *name, mpool_t const *pool) {
+	pool_stats_t const *stats = mpool_get_stats(pool);
+
+	printf("pool=%s blocks=%lu min_free=%lu gets=%lu failed=%lu puts=%lu\n", name,
+			(unsigned long) stats->numBlocks, (unsigned long) stats->minFree,
+			(unsigned long) stats->nGet, (unsigned long) stats->nFail,
+			(unsigned long) stats->nPut);
+	for (uint32_t i = 0u; (i < POOL_STATS_MAX_OWNERS)
+			&& (stats->owner[i].ctx != POOL_STATS_NO_OWNER); i++) {
+		printf("pool=%s owner=%s used=%u peak=%u\n", name,
+				BSP_host_ctx_name(stats->owner[i].ctx), (unsigned) stats->owner[i].used,
+				(unsigned) stats->owner[i].peak);
+	}
+	printf("pool=%s get_hist_log2_ns=", name);
+	for (uint32_t i = 0u; i < POOL_STATS_HIST_BINS; i++) {
+		printf((i == 0u) ? "%lu" : ",%lu", (unsigned long) stats->getHist[i]);
+	}
+	printf(" put_hist_log2_ns=");
+	for (uint32_t i = 0u; i < POOL_STATS_HIST_BINS; i++) {
+		printf((i == 0u) ? "%lu" : ",%lu", (unsigned long) stats->putHist[i]);
+	}
+	printf("\n");
+}
+#endif
+
+void BSP_host_report(void) {
+	double wall_s = (double) (SST_PORT_now_ns() - wallStart_ns) / 1e9;
+	uint32_t total = SST_Task_getPortStat(AO_SpiMgr)->nDispatch
+			+ SST_Task_getPortStat(AO_LIS3DSH)->nDispatch
+			+ SST_Task_getPortStat(AO_Blink)->nDispatch;
+	LIS3DSH_Sample_t sample = LIS3DSH_read();
+
+	BSP_host_report_task("spi_mgr", AO_SpiMgr);
+	BSP_host_report_task("LIS3DSH", AO_LIS3DSH);
+	BSP_host_report_task("blinky", AO_Blink);
+	printf("sim_ms=%lu wall_s=%.6f events=%lu events_per_s=%.0f\n",
+			(unsigned long) simTime_ms, wall_s, (unsigned long) total,
+			(wall_s > 0.0) ? ((double) total / wall_s) : 0.0);
+	printf("tickless=%u tick_wakeups=%lu\n", simTickless,
+			(unsigned long) simWakeups);
+	printf("spi_mode=%s spi_irqs=%lu polled_segs=%lu reconfigs=%lu\n",
+			(simSpiReg != 0u) ? "reg" : ((simSpiDma != 0u) ? "dma" : "it"),
+			(unsigned long) simSpiIrqs, (unsigned long) SpiMgrInstance.nPolledSegs,
+			(unsigned long) SpiMgrInstance.nReconfig);
+	printf("spi_timeouts=%lu retries=%lu abandoned=%lu late_cplt=%lu\n",
+			(unsigned long) SpiMgrInstance.nTimeouts, (unsigned long) SpiMgrInstance.nRetries,
+			(unsigned long) SpiMgrInstance.nAbandoned, (unsigned long) SpiMgrInstance.nLateCplt);
+	printf("evt_pool_free=%lu/%lu sample_pool_free=%lu/%lu small_pool_free=%lu/%lu\n",
+			(unsigned long) evtPool.free, (unsigned long) EVT_POOL_LEN,
+			(unsigned long) samplePool.free, (unsigned long) SAMPLE_POOL_LEN,
+			(unsigned long) smallPool.free, (unsigned long) SMALL_POOL_LEN);
+	for (uint8_t poolNum = 1u; poolNum <= EVT_POOL_CLASSES; poolNum++) {
+		SST_EvtPoolStat const *pool = SST_Evt_getPoolStat(poolNum);
+		printf("evt_pool=%u alloc=%lu fallback=%lu empty=%lu used=%u max_used=%u\n",
+				(unsigned) poolNum, (unsigned long) pool->nAlloc,
+				(unsigned long) pool->nFallback, (unsigned long) pool->nEmpty,
+				(unsigned) pool->nUsed, (unsigned) pool->maxUsed);
+	}
+#if (POOL_STATS != 0)
+	BSP_host_report_pool("small", &smallPool);
+	BSP_host_report_pool("sample", &samplePool);
+	BSP_host_report_pool("evt", &evtPool);
+#endif
+	printf("accel_xyz_gQ14=%d,%d,%d sample_seq=%lu sample_ms=%lu\n",
+			sample.Results.x_gQ14, sample.Results.y_gQ14, sample.Results.z_gQ14,
+			(unsigned long) sample.seq, (unsigned long) sample.timestamp_ms);
+	printf("led_duty_bROG=%u,%u,%u,%u\n", LEDDuty[0], LEDDuty[1], LEDDuty[2],
+			LEDDuty[3]);
+}
+
+void SST_onStart(void) {
+	wallStart_ns = SST_PORT_now_ns();
+}
+
+/*advance the simulated time by one tick*/
+static void BSP_host_advance(void) {
+	simTime_ms++;
+	HAL_IncTick();
+	LIS3DSH_sim_sample(&LIS3DSHSim, simTime_ms);
+}
+
+/*ticks skipped by the simulated tickless idle, from the simulated SysTick before its own tick*/
+void SST_onTicklessWake(SST_TCtr ticks) {
+	for (SST_TCtr i = 0u; i < ticks; i++) {
+		BSP_host_advance();
+	}
+	SST_TimeEvt_catchUp(ticks);
+}
+
+/*the simulated SysTick_Handler, folds in the ticks the tickless idle skipped like the target*/
+static void BSP_host_SysTick(void) {
+	if (simSkipped != 0u) {
+		SST_onTicklessWake((SST_TCtr) simSkipped);
+		simSkipped = 0u;
+	}
+	simWakeups++;
+	BSP_host_advance();
+	SST_TimeEvt_tick(); /* process all SST time events */
+}
+
+/*the idle loop raises the simulated interrupts: the SPI byte (HAL or register engine) or DMA
+ *transfer complete first, otherwise the next tick*/
+void SST_onIdle(void) {
+	if (simTime_ms >= simRunTime_ms) {
+		BSP_host_report();
+		exit(0);
+	}
+
+	SST_PORT_isrEntry();
+	uint8_t spiIrq = 1u;
+	if ((HAL_host_SPI_IRQHandler(&hspi1) != 0) || (HAL_host_DMA_IRQHandler(&hdma_spi1_rx) != 0)
+			|| (HAL_host_DMA_IRQHandler(&hdma_spi1_tx) != 0)) {
+		simSpiIrqs++;
+	} else if (HAL_host_SPI_regIRQ(SPI1) != 0) {
+		SPIManager_reg_IRQHandler(&SpiMgrInstance);
+		simSpiIrqs++;
+	} else {
+		spiIrq = 0u;
+	}
+	SST_PORT_isrExit();
+	if (spiIrq != 0u) {
+		return;
+	}
+
+	if (simTickless != 0u) {
+		/*sleep until the earliest time event (or the end of the run), the skipped ticks are left
+		 *to the tick interrupt that ends the sleep, as on the target*/
+		SST_PORT_critEntry();
+		uint32_t ticks = SST_TimeEvt_nextTick();
+		uint32_t ticksLeft = simRunTime_ms - simTime_ms;
+		if ((ticks == 0u) || (ticks > ticksLeft)) {
+			ticks = ticksLeft;
+		}
+		simSkipped += ticks - 1u;
+		SST_PORT_critExit();
+	}
+	SST_PORT_isrEntry();
+	BSP_host_SysTick();
+	SST_PORT_isrExit();
+}
+
+void set_blue_LED_duty(uint16_t duty) {
+	LEDDuty[0] = duty;
+}
+void set_red_LED_duty(uint16_t duty) {
+	LEDDuty[1] = duty;
+}
+
+void set_orange_LED_duty(uint16_t duty) {
+	LEDDuty[2] = duty;
+}
+
+void set_green_LED_duty(uint16_t duty) {
+	LEDDuty[3] = duty;
+}
+
+void DBC_fault_handler(char const *const module, int const label) {
+	fprintf(stderr, "DBC assertion failed: %s:%d\n", module, label);
+	abort();
+}
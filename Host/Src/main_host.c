@@ -0,0 +1,46 @@
+/*
+ * main_host.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Entry point of the host (Linux) build of the application.
+ *      usage: sst_host [simulated run time in ms, default 10000] [tickless] [dma|reg] [drop=<per mille>]
+ *             sst_host bench [name|all]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sst.h"
+#include "bsp.h"
+#include "bsp_host.h"
+
+int main(int argc, char *argv[]) {
+	uint32_t run_ms = 10000u;
+
+	if ((argc > 1) && (strcmp(argv[1], "bench") == 0)) {
+		return BSP_host_bench((argc > 2) ? argv[2] : "all");
+	}
+	if (argc > 1) {
+		run_ms = (uint32_t) strtoul(argv[1], NULL, 10);
+	}
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "tickless") == 0) {
+			BSP_host_setTickless(1u);
+		} else if (strcmp(argv[i], "dma") == 0) {
+			BSP_host_setSpiDma(1u);
+		} else if (strcmp(argv[i], "reg") == 0) {
+			BSP_host_setSpiReg(1u);
+		} else if (strncmp(argv[i], "drop=", 5) == 0) {
+			BSP_host_setSpiDropRate((uint32_t) strtoul(&argv[i][5], NULL, 10));
+		}
+	}
+	BSP_host_setRunTime(run_ms);
+
+	SST_init(); /*initialise super simple tasker kernel*/
+	BSP_init();
+
+	/*Start the application, returns through exit() once the run time has elapsed*/
+	return SST_Task_run();
+}
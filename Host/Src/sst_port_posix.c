@@ -0,0 +1,243 @@
+/*===========================================================================
+* Super-Simple Tasker (SST/C) port to a POSIX host (Linux)
+*
+* SPDX-License-Identifier: MIT
+===========================================================================*/
+#define _POSIX_C_SOURCE 199309L /* clock_gettime() */
+
+#include "sst.h"        /* Super-Simple Tasker (SST/C) */
+#include "dbc_assert.h" /* Design By Contract (DBC) assertions */
+
+#include <time.h>
+
+DBC_MODULE_NAME("sst_port_posix") /* for DBC assertions in this module */
+
+/* priority level of simulated ISRs, above any SST task priority */
+#define SST_PORT_ISR_PRIO (0x100U)
+
+/*..........................................................................*/
+/* tasks sorted by descending priority and then ascending IRQ, so that the
+* lowest set bit in sst_readySet is always the next task to run (NVIC order)
+*/
+static SST_Task *sst_tasks[SST_PORT_MAX_TASKS];
+static uint32_t sst_nTasks;
+static uint32_t sst_readySet;  /* "NVIC pending" bits (atomic access) */
+static uint32_t sst_currPrio;  /* priority of the running task or ISR */
+static uint32_t sst_ceiling;   /* scheduler lock ceiling ("BASEPRI") */
+static uint32_t sst_critNest;  /* critical section nesting */
+static uint32_t sst_isrNest;   /* simulated ISR nesting */
+static uint32_t sst_isrPrev;   /* priority preempted by the outermost ISR */
+static uint16_t sst_currCtx;   /* "IPSR" of the running task or ISR */
+static uint16_t sst_isrPrevCtx;
+static _Thread_local bool sst_isSstThread; /* thread running the tasks */
+
+static void SST_PORT_schedule(void);
+
+/* SST kernel facilities ---------------------------------------------------*/
+void SST_init(void) {
+    sst_isSstThread = true;
+    sst_nTasks   = 0U;
+    sst_readySet = 0U;
+    sst_currPrio = 0U;
+    sst_ceiling  = 0U;
+    sst_critNest = 0U;
+    sst_isrNest  = 0U;
+    sst_currCtx  = 0U;
+}
+/*..........................................................................*/
+void SST_start(void) {
+    /* run whatever became ready while the application was initialised */
+    SST_PORT_schedule();
+}
+
+/* SST Task facilities -----------------------------------------------------*/
+void SST_Task_setIRQ(SST_Task * const me, uint8_t irq) {
+    me->irq = irq;
+}
+/*..........................................................................*/
+void SST_Task_setPrio(SST_Task * const me, SST_TaskPrio prio) {
+    /*! @pre
+    * - the host scheduler must have room for the task
+    * - no task may be pending while the task table is re-ordered
+    */
+    DBC_REQUIRE(200,
+                (sst_nTasks < SST_PORT_MAX_TASKS)
+                && (sst_readySet == 0U));
+
+    me->prio = prio;
+    me->portStat.nDispatch = 0U;
+    me->portStat.nActivate = 0U;
+    me->portStat.latTotal_ns = 0U;
+    me->portStat.latMax_ns = 0U;
+
+    /* insertion sort by priority (descending), then IRQ (ascending) */
+    uint32_t i = sst_nTasks;
+    while ((i > 0U)
+           && ((sst_tasks[i - 1U]->prio < prio)
+               || ((sst_tasks[i - 1U]->prio == prio)
+                   && (sst_tasks[i - 1U]->irq > me->irq))))
+    {
+        sst_tasks[i] = sst_tasks[i - 1U];
+        --i;
+    }
+    sst_tasks[i] = me;
+    ++sst_nTasks;
+
+    /* re-assign the ready-set bits to match the new order */
+    for (i = 0U; i < sst_nTasks; ++i) {
+        sst_tasks[i]->pend_bit = (1U << i);
+    }
+}
+/*..........................................................................*/
+void SST_Task_activate(SST_Task * const me) {
+    SST_QCtr nBatch = me->batch; /* events left in this activation */
+    bool more;
+    do {
+        /* get the event out of the queue */
+        /* NOTE: no critical section because me->tail is accessed only
+        * from this task. An empty entry was reserved by a producer that
+        * has not stored its event yet (that producer pends the task again)
+        * or this activation was pended for an event already drained by a
+        * previous batch.
+        */
+        SST_Evt const *e = SST_PORT_EVT_LOAD(&me->qBuf[me->tail]);
+        if (e == (SST_Evt const *)0) {
+            break;
+        }
+        uint64_t post_ns = __atomic_load_n(&me->post_ns[me->tail],
+                                           __ATOMIC_RELAXED);
+        SST_PORT_EVT_STORE(&me->qBuf[me->tail], (SST_Evt const *)0);
+        if (me->tail == 0U) { /* need to wrap the tail? */
+            me->tail = me->end; /* wrap around */
+        }
+        else {
+            --me->tail;
+        }
+        --nBatch;
+
+        SST_QCtr nUsed;
+        do { /* release the entry for the producers */
+            nUsed = SST_PORT_LOAD8(&me->nUsed);
+        } while (!SST_PORT_CAS8(&me->nUsed, nUsed, (SST_QCtr)(nUsed - 1U)));
+        more = (nUsed > 1U); /* some events still present in the queue? */
+        if (more && (nBatch == 0U)) { /* batch used up? */
+            /* <=== pend the task again */
+            __atomic_fetch_or(&sst_readySet, me->pend_bit, __ATOMIC_SEQ_CST);
+        }
+
+        uint64_t lat_ns = SST_PORT_now_ns() - post_ns;
+        ++me->portStat.nDispatch;
+        me->portStat.latTotal_ns += lat_ns;
+        if (lat_ns > me->portStat.latMax_ns) {
+            me->portStat.latMax_ns = lat_ns;
+        }
+
+        /* dispatch the received event to this task */
+        SST_TASK_STAT_BEGIN(t0);
+        (*me->dispatch)(me, e); /* NOTE: virtual call */
+        SST_TASK_STAT_END(me, nUsed, t0);
+        SST_Evt_gc(e); /* recycle the event, if dynamic */
+    } while (more && (nBatch > 0U));
+    ++me->portStat.nActivate;
+}
+/*..........................................................................*/
+SST_PortStat const *SST_Task_getPortStat(SST_Task const * const me) {
+    return &me->portStat;
+}
+
+/*..........................................................................*/
+SST_LockKey SST_Task_lock(SST_TaskPrio ceiling) {
+    SST_LockKey lock_key = sst_ceiling;
+    if (sst_ceiling < ceiling) { /* current ceiling lower than requested? */
+        sst_ceiling = ceiling;
+    }
+    return lock_key;
+}
+/*..........................................................................*/
+void SST_Task_unlock(SST_LockKey lock_key) {
+    sst_ceiling = lock_key;
+    SST_PORT_schedule(); /* tasks blocked by the ceiling may run now */
+}
+
+/* host scheduler ----------------------------------------------------------*/
+void SST_PORT_critEntry(void) {
+    ++sst_critNest;
+}
+/*..........................................................................*/
+void SST_PORT_critExit(void) {
+    /*! @pre critical sections must be balanced */
+    DBC_REQUIRE(400, sst_critNest > 0U);
+
+    if (--sst_critNest == 0U) {
+        SST_PORT_schedule();
+    }
+}
+/*..........................................................................*/
+void SST_PORT_taskPend(struct SST_Task * const me) {
+    __atomic_fetch_or(&sst_readySet, me->pend_bit, __ATOMIC_SEQ_CST);
+    if (sst_isSstThread) {
+        SST_PORT_schedule(); /* like the NVIC taking the pended IRQ */
+    }
+}
+/*..........................................................................*/
+void SST_PORT_isrEntry(void) {
+    if (sst_isrNest++ == 0U) {
+        sst_isrPrev = sst_currPrio;
+        sst_currPrio = SST_PORT_ISR_PRIO;
+        sst_isrPrevCtx = sst_currCtx;
+        sst_currCtx = SST_PORT_ISR_CTX;
+    }
+}
+/*..........................................................................*/
+void SST_PORT_isrExit(void) {
+    /*! @pre ISR entry/exit must be balanced */
+    DBC_REQUIRE(500, sst_isrNest > 0U);
+
+    if (--sst_isrNest == 0U) {
+        sst_currPrio = sst_isrPrev;
+        sst_currCtx = sst_isrPrevCtx;
+        SST_PORT_schedule(); /* tail-chain into the ready tasks */
+    }
+}
+/*..........................................................................*/
+uint16_t SST_PORT_currCtx(void) {
+    return sst_currCtx;
+}
+/*..........................................................................*/
+uint8_t SST_PORT_currPrio(void) {
+    return (sst_currPrio < SST_PORT_PRIO_ISR)
+           ? (uint8_t)sst_currPrio : (uint8_t)SST_PORT_PRIO_ISR;
+}
+/*..........................................................................*/
+uint64_t SST_PORT_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+/*..........................................................................*/
+static void SST_PORT_schedule(void) {
+    if ((sst_critNest != 0U) || (sst_isrNest != 0U)) {
+        return; /* the scheduler runs only when leaving these contexts */
+    }
+    uint32_t readySet;
+    while ((readySet = __atomic_load_n(&sst_readySet, __ATOMIC_ACQUIRE))
+           != 0U)
+    {
+        SST_Task *t = sst_tasks[__builtin_ctz(readySet)];
+        uint32_t threshold = (sst_currPrio > sst_ceiling)
+                             ? sst_currPrio : sst_ceiling;
+        if (t->prio <= threshold) { /* cannot preempt the current level? */
+            break;
+        }
+        /* "NVIC" clears the pending bit */
+        __atomic_fetch_and(&sst_readySet, ~t->pend_bit, __ATOMIC_SEQ_CST);
+
+        uint32_t prev = sst_currPrio;
+        uint16_t prevCtx = sst_currCtx;
+        sst_currPrio = t->prio;
+        sst_currCtx = (uint16_t)(16U + t->irq);
+        SST_Task_activate(t);
+        sst_currPrio = prev;
+        sst_currCtx = prevCtx;
+    }
+}
@@ -0,0 +1,306 @@
+/*
+ * stm32f4xx_hal_host.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ *      Host stand-in for the STM32F4 HAL GPIO and SPI calls used by the application.
+ *      A transfer started with HAL_SPI_TransmitReceive_IT (or Transmit_IT/Receive_IT) stays in
+ *      progress until the host board calls HAL_host_SPI_IRQHandler() from a simulated ISR, which
+ *      clocks the bytes through whichever attached slave has its chip select low. Code that drives
+ *      the SPI registers itself goes through the register model (HAL_host_SPI_readSR etc.).
+ */
+
+#include "stm32f4xx_hal.h"
+#include "dbc_assert.h"
+
+DBC_MODULE_NAME("hal_host")
+
+#define HAL_HOST_MAX_SLAVES (4u)
+#define HAL_HOST_SPI_CHUNK (64u) /*bytes of the dummy buffer of transmit or receive only transfers*/
+
+typedef struct {
+	GPIO_TypeDef *pcsGPIOPort;
+	uint16_t csGPIOPin;
+	HAL_host_SPISlave_t xfer;
+	void *pSlave;
+	uint8_t inFrame; /*bytes clocked since the chip select went low*/
+} HAL_host_Slave_t;
+
+GPIO_TypeDef HAL_host_GPIO[8];
+SPI_TypeDef HAL_host_SPI[3] = { { .SR = SPI_SR_TXE }, { .SR = SPI_SR_TXE }, { .SR = SPI_SR_TXE } };
+
+static uint32_t uwTick; /*ms since start, as the HAL tick*/
+
+static HAL_host_Slave_t slaves[HAL_HOST_MAX_SLAVES];
+static uint32_t numSlaves;
+
+static uint32_t dropPerMille; /*share of complete callbacks lost*/
+static uint32_t dropRand = 0x2545F491u; /*xorshift32 state*/
+
+void HAL_IncTick(void) {
+	uwTick++;
+}
+
+uint32_t HAL_GetTick(void) {
+	return uwTick;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+		GPIO_PinState PinState) {
+	if (PinState == GPIO_PIN_SET) {
+		GPIOx->ODR |= GPIO_Pin;
+		for (uint32_t i = 0; i < numSlaves; i++) {
+			if ((slaves[i].pcsGPIOPort == GPIOx) && ((slaves[i].csGPIOPin & GPIO_Pin) != 0u)) {
+				slaves[i].inFrame = 0u; /*deselected, the next transfer starts a new frame*/
+			}
+		}
+	} else {
+		GPIOx->ODR &= ~(uint32_t) GPIO_Pin;
+	}
+}
+
+static HAL_StatusTypeDef HAL_host_SPI_start(SPI_HandleTypeDef *hspi, uint8_t *pTxData,
+		uint8_t *pRxData, uint16_t Size, HAL_SPI_StateTypeDef state, uint8_t dma) {
+	if ((hspi->State == HAL_SPI_STATE_BUSY_TX_RX) || (hspi->State == HAL_SPI_STATE_BUSY_TX)
+			|| (hspi->State == HAL_SPI_STATE_BUSY_RX)) {
+		return HAL_BUSY;
+	}
+	if ((Size == 0u) || ((dma != 0u) && ((hspi->hdmatx == NULL) || (hspi->hdmarx == NULL)))) {
+		return HAL_ERROR;
+	}
+	hspi->pTxBuffPtr = pTxData;
+	hspi->pRxBuffPtr = pRxData;
+	hspi->XferSize = Size;
+	hspi->XferCount = Size;
+	hspi->hostDma = dma;
+	hspi->State = state;
+	if (dma != 0u) {
+		hspi->hdmarx->State = HAL_DMA_STATE_BUSY;
+		hspi->hdmatx->State = HAL_DMA_STATE_BUSY;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi,
+		uint8_t *pTxData, uint8_t *pRxData, uint16_t Size) {
+	if ((pTxData == NULL) || (pRxData == NULL)) {
+		return HAL_ERROR;
+	}
+	return HAL_host_SPI_start(hspi, pTxData, pRxData, Size, HAL_SPI_STATE_BUSY_TX_RX, 0u);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_IT(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size) {
+	if (pData == NULL) {
+		return HAL_ERROR;
+	}
+	return HAL_host_SPI_start(hspi, pData, NULL, Size, HAL_SPI_STATE_BUSY_TX, 0u);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_IT(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size) {
+	if (pData == NULL) {
+		return HAL_ERROR;
+	}
+	return HAL_host_SPI_start(hspi, NULL, pData, Size, HAL_SPI_STATE_BUSY_RX, 0u);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi,
+		uint8_t *pTxData, uint8_t *pRxData, uint16_t Size) {
+	if ((pTxData == NULL) || (pRxData == NULL)) {
+		return HAL_ERROR;
+	}
+	return HAL_host_SPI_start(hspi, pTxData, pRxData, Size, HAL_SPI_STATE_BUSY_TX_RX, 1u);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size) {
+	if (pData == NULL) {
+		return HAL_ERROR;
+	}
+	return HAL_host_SPI_start(hspi, pData, NULL, Size, HAL_SPI_STATE_BUSY_TX, 1u);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData,
+		uint16_t Size) {
+	if (pData == NULL) {
+		return HAL_ERROR;
+	}
+	return HAL_host_SPI_start(hspi, NULL, pData, Size, HAL_SPI_STATE_BUSY_RX, 1u);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi) {
+	hspi->State = HAL_SPI_STATE_READY;
+	if (hspi->hostDma != 0u) {
+		hspi->hdmarx->State = HAL_DMA_STATE_READY;
+		hspi->hdmatx->State = HAL_DMA_STATE_READY;
+	}
+	return HAL_OK;
+}
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi) {
+	return hspi->State;
+}
+
+void HAL_host_SPI_setDropRate(uint32_t perMille) {
+	dropPerMille = perMille;
+}
+
+void HAL_host_SPI_attach(GPIO_TypeDef *pcsGPIOPort, uint16_t csGPIOPin,
+		HAL_host_SPISlave_t xfer, void *pSlave) {
+	DBC_ASSERT(10, (numSlaves < HAL_HOST_MAX_SLAVES) && (xfer != NULL));
+
+	slaves[numSlaves].pcsGPIOPort = pcsGPIOPort;
+	slaves[numSlaves].csGPIOPin = csGPIOPin;
+	slaves[numSlaves].xfer = xfer;
+	slaves[numSlaves].pSlave = pSlave;
+	numSlaves++;
+}
+
+/*clocks len bytes through the selected slaves, MISO floats high when no slave is selected*/
+static void HAL_host_SPI_clock(uint8_t const *tx, uint8_t *rx, uint16_t len) {
+	for (uint32_t i = 0; i < len; i++) {
+		rx[i] = 0xFFu;
+	}
+	for (uint32_t i = 0; i < numSlaves; i++) {
+		if ((slaves[i].pcsGPIOPort->ODR & slaves[i].csGPIOPin) == 0u) {
+			slaves[i].xfer(slaves[i].pSlave, tx, rx, len, slaves[i].inFrame == 0u);
+			slaves[i].inFrame = 1u;
+		}
+	}
+}
+
+/*the byte on the bus has been clocked*/
+static void HAL_host_SPI_regDone(SPI_TypeDef *SPIx) {
+	SPIx->hostBusy = 0u;
+	SPIx->SR = (SPIx->SR & ~SPI_SR_BSY) | SPI_SR_RXNE;
+}
+
+uint32_t HAL_host_SPI_readSR(SPI_TypeDef *SPIx) {
+	SPIx->hostAccesses++;
+	if ((SPIx->hostBusy != 0u) && (--SPIx->hostBusy == 0u)) {
+		HAL_host_SPI_regDone(SPIx);
+	}
+	return SPIx->SR;
+}
+
+void HAL_host_SPI_writeDR(SPI_TypeDef *SPIx, uint8_t data) {
+	uint8_t rx;
+
+	SPIx->hostAccesses++;
+	if ((SPIx->CR1 & SPI_CR1_SPE) == 0u) {
+		return; /*disabled, nothing is clocked*/
+	}
+	if ((SPIx->SR & SPI_SR_RXNE) != 0u) {
+		SPIx->SR |= SPI_SR_OVR; /*the last byte received was not read*/
+	}
+	HAL_host_SPI_clock(&data, &rx, 1u);
+	SPIx->DR = rx;
+	SPIx->SR |= SPI_SR_TXE; /*the shift register took the byte straight away*/
+	if (SPIx->hostByteTime == 0u) {
+		HAL_host_SPI_regDone(SPIx);
+	} else {
+		SPIx->hostBusy = SPIx->hostByteTime;
+		SPIx->SR = (SPIx->SR & ~SPI_SR_RXNE) | SPI_SR_BSY;
+	}
+}
+
+uint8_t HAL_host_SPI_readDR(SPI_TypeDef *SPIx) {
+	SPIx->hostAccesses++;
+	SPIx->SR &= ~SPI_SR_RXNE;
+	return (uint8_t) SPIx->DR;
+}
+
+int HAL_host_SPI_regIRQ(SPI_TypeDef *SPIx) {
+	if (SPIx->hostBusy != 0u) {
+		HAL_host_SPI_regDone(SPIx);
+	}
+	return ((SPIx->SR & SPI_SR_RXNE) != 0u) && ((SPIx->CR2 & SPI_CR2_RXNEIE) != 0u);
+}
+
+/*clocks len bytes of the transfer in progress from offset done, transmit or receive only transfers
+ *go through the dummy buffers*/
+static void HAL_host_SPI_xfer(SPI_HandleTypeDef *hspi, uint16_t done, uint16_t len) {
+	static uint8_t const dummyTx[HAL_HOST_SPI_CHUNK]; /*receive only clocks out zeros*/
+	static uint8_t dummyRx[HAL_HOST_SPI_CHUNK]; /*transmit only drops MISO*/
+
+	if (hspi->State == HAL_SPI_STATE_BUSY_TX_RX) {
+		HAL_host_SPI_clock(&hspi->pTxBuffPtr[done], &hspi->pRxBuffPtr[done], len);
+		return;
+	}
+	uint32_t end = (uint32_t) done + len;
+	for (uint32_t i = done; i < end;) {
+		uint16_t chunk = (uint16_t) (((end - i) < HAL_HOST_SPI_CHUNK) ? (end - i) : HAL_HOST_SPI_CHUNK);
+		if (hspi->State == HAL_SPI_STATE_BUSY_TX) {
+			HAL_host_SPI_clock(&hspi->pTxBuffPtr[i], dummyRx, chunk);
+		} else {
+			HAL_host_SPI_clock(dummyTx, &hspi->pRxBuffPtr[i], chunk);
+		}
+		i += chunk;
+	}
+}
+
+/*transfer done, back to ready and the complete callback of its kind*/
+static void HAL_host_SPI_complete(SPI_HandleTypeDef *hspi) {
+	HAL_SPI_StateTypeDef state = hspi->State;
+
+	hspi->XferCount = 0u;
+	hspi->State = HAL_SPI_STATE_READY;
+	if (hspi->hostDma != 0u) {
+		hspi->hdmarx->State = HAL_DMA_STATE_READY;
+		hspi->hdmatx->State = HAL_DMA_STATE_READY;
+	}
+	if (dropPerMille != 0u) {
+		dropRand ^= dropRand << 13;
+		dropRand ^= dropRand >> 17;
+		dropRand ^= dropRand << 5;
+		if ((dropRand % 1000u) < dropPerMille) {
+			return; /*the transfer is done but its interrupt is lost*/
+		}
+	}
+	if (hspi->hostCpltCallback != NULL) {
+		hspi->hostCpltCallback(hspi);
+	} else if (state == HAL_SPI_STATE_BUSY_TX_RX) {
+		HAL_SPI_TxRxCpltCallback(hspi);
+	} else if (state == HAL_SPI_STATE_BUSY_TX) {
+		HAL_SPI_TxCpltCallback(hspi);
+	} else {
+		HAL_SPI_RxCpltCallback(hspi);
+	}
+}
+
+static int HAL_host_SPI_busy(SPI_HandleTypeDef *hspi) {
+	return (hspi->State == HAL_SPI_STATE_BUSY_TX_RX) || (hspi->State == HAL_SPI_STATE_BUSY_TX)
+			|| (hspi->State == HAL_SPI_STATE_BUSY_RX);
+}
+
+int HAL_host_SPI_IRQHandler(SPI_HandleTypeDef *hspi) {
+	if (!HAL_host_SPI_busy(hspi) || (hspi->hostDma != 0u)) {
+		return 0;
+	}
+
+	/*RXNE of one byte, as the HAL interrupt handler does a byte per interrupt*/
+	HAL_host_SPI_xfer(hspi, (uint16_t) (hspi->XferSize - hspi->XferCount), 1u);
+	hspi->XferCount--;
+	if (hspi->XferCount == 0u) {
+		HAL_host_SPI_complete(hspi);
+	}
+	return 1;
+}
+
+int HAL_host_DMA_IRQHandler(DMA_HandleTypeDef *hdma) {
+	SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef*) hdma->Parent;
+
+	if ((hspi == NULL) || !HAL_host_SPI_busy(hspi) || (hspi->hostDma == 0u)) {
+		return 0;
+	}
+	/*the rx stream finishes last, a transmit only transfer ends on the tx stream*/
+	if (hdma != ((hspi->State == HAL_SPI_STATE_BUSY_TX) ? hspi->hdmatx : hspi->hdmarx)) {
+		return 0;
+	}
+
+	HAL_host_SPI_xfer(hspi, 0u, hspi->XferSize);
+	HAL_host_SPI_complete(hspi);
+	return 1;
+}